@@ -0,0 +1,152 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "AsyncLogger.h"
+#include <cstdio>
+#include <ctime>
+
+namespace MESLog
+{
+    Level LevelFromString(const std::string& s) noexcept
+    {
+        if (s == "debug") return Level::debug;
+        if (s == "warn") return Level::warn;
+        if (s == "error") return Level::error;
+        if (s == "off") return Level::off;
+        return Level::info;
+    }
+
+    AsyncLogger & AsyncLogger::Instance()
+    {
+        static AsyncLogger logger;
+        return logger;
+    }
+
+    AsyncLogger::AsyncLogger()
+        : worker_([this] { Run(); })
+    {
+    }
+
+    AsyncLogger::~AsyncLogger()
+    {
+        {
+            std::lock_guard lock(wake_mutex_);
+            stopping_ = true;
+        }
+        wake_cv_.notify_one();
+        worker_.join();
+    }
+
+    RecordRing & AsyncLogger::ThreadRing()
+    {
+        // Rings are shared with the registry so records of exited threads are still written
+        thread_local std::shared_ptr<RecordRing> ring = [this] {
+            auto r = std::make_shared<RecordRing>();
+            std::lock_guard lock(rings_mutex_);
+            rings_.push_back(r);
+            return r;
+        }();
+        return *ring;
+    }
+
+    void AsyncLogger::Flush()
+    {
+        std::unique_lock lock(wake_mutex_);
+        const auto ticket = flush_requests_.fetch_add(1) + 1;
+        wake_cv_.notify_one();
+        flushed_cv_.wait(lock, [&] { return flush_done_.load() >= ticket || stopping_; });
+    }
+
+    void AsyncLogger::Run()
+    {
+        while (true)
+        {
+            const auto requested = flush_requests_.load();
+            const size_t written = DrainAll();
+            if (requested > flush_done_.load())
+            {
+                std::lock_guard lock(wake_mutex_);
+                flush_done_.store(requested);
+                flushed_cv_.notify_all();
+            }
+
+            std::unique_lock lock(wake_mutex_);
+            if (stopping_)
+                break;
+            // Producers never signal, the thread polls while idle to keep logging calls syscall-free
+            if (written == 0)
+                wake_cv_.wait_for(lock, std::chrono::milliseconds(2));
+        }
+        DrainAll();
+        std::fflush(stdout);
+        flushed_cv_.notify_all();
+    }
+
+    size_t AsyncLogger::DrainAll()
+    {
+        std::vector<std::shared_ptr<RecordRing>> rings;
+        {
+            std::lock_guard lock(rings_mutex_);
+            rings = rings_;
+        }
+        std::string line;
+        size_t written = 0;
+        for (const auto & ring : rings)
+            written += ring->Drain([&line](const Record & record) { Write(record, line); });
+        if (written > 0)
+            std::fflush(stdout);
+        return written;
+    }
+
+    void AsyncLogger::Write(const Record& record, std::string& line)
+    {
+        static constexpr const char * level_names[] = {"DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+        line.clear();
+
+        const auto seconds = static_cast<std::time_t>(record.timestamp_ns / 1000000000ull);
+        std::tm tm{};
+#ifdef _WIN32
+        localtime_s(&tm, &seconds);
+#else
+        localtime_r(&seconds, &tm);
+#endif
+        char prefix[64];
+        const int n = std::snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d.%06llu] [%s] ",
+            tm.tm_hour, tm.tm_min, tm.tm_sec,
+            static_cast<unsigned long long>(record.timestamp_ns % 1000000000ull / 1000),
+            level_names[static_cast<size_t>(record.level)]);
+        line.append(prefix, n > 0 ? static_cast<size_t>(n) : 0);
+
+        // Every {...} placeholder takes the next argument, format specs are ignored
+        size_t next_arg = 0;
+        for (const char * p = record.fmt; *p != '\0'; ++p)
+        {
+            if (*p != '{')
+            {
+                line.push_back(*p);
+                continue;
+            }
+            const char * close = p;
+            while (*close != '\0' && *close != '}')
+                ++close;
+            if (*close == '\0' || next_arg >= record.num_args)
+            {
+                line.append(p);
+                break;
+            }
+            const auto & arg = record.args[next_arg++];
+            char buf[32];
+            switch (arg.kind)
+            {
+                case Arg::Kind::i64: line.append(buf, std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(arg.i))); break;
+                case Arg::Kind::u64: line.append(buf, std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(arg.u))); break;
+                case Arg::Kind::f64: line.append(buf, std::snprintf(buf, sizeof(buf), "%g", arg.d)); break;
+                case Arg::Kind::str: line.append(arg.s); break;
+            }
+            p = close;
+        }
+        line.push_back('\n');
+        std::fwrite(line.data(), 1, line.size(), stdout);
+    }
+}
@@ -0,0 +1,217 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_ASYNCLOGGER_H
+#define RECONFIGMANUS_ASYNCLOGGER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Lowest level compiled in: 0 debug, 1 info, 2 warn, 3 error, 4 off. Lower-level calls compile to nothing.
+#ifndef MES_LOG_COMPILE_LEVEL
+#define MES_LOG_COMPILE_LEVEL 1
+#endif
+
+namespace MESLog
+{
+    enum class Level : uint8_t
+    {
+        debug, info, warn, error, off
+    };
+
+    Level LevelFromString(const std::string& s) noexcept;
+
+    // One captured argument, strings are copied inline and truncated
+    struct Arg
+    {
+        enum class Kind : uint8_t { i64, u64, f64, str };
+        Kind kind{};
+        union
+        {
+            int64_t i;
+            uint64_t u;
+            double d;
+            char s[24];
+        };
+    };
+
+    // Binary log record, formatted later on the logger thread. fmt must be a string literal.
+    struct Record
+    {
+        static constexpr size_t kMaxArgs = 6;
+        uint64_t timestamp_ns{};
+        const char * fmt{};
+        Level level{};
+        uint8_t num_args{};
+        std::array<Arg, kMaxArgs> args;
+    };
+
+    // Single-producer single-consumer ring, one per logging thread
+    class RecordRing
+    {
+    public:
+        static constexpr size_t kCapacity = 1024;
+
+        Record * TryClaim()
+        {
+            const auto head = head_.load(std::memory_order_relaxed);
+            if (head - tail_.load(std::memory_order_acquire) >= kCapacity)
+                return nullptr;
+            return &records_[head % kCapacity];
+        }
+        void Publish() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+        template <typename Fn>
+        size_t Drain(Fn && fn)
+        {
+            const auto head = head_.load(std::memory_order_acquire);
+            auto tail = tail_.load(std::memory_order_relaxed);
+            const size_t count = head - tail;
+            for (; tail != head; ++tail)
+                fn(records_[tail % kCapacity]);
+            tail_.store(tail, std::memory_order_release);
+            return count;
+        }
+
+    private:
+        alignas(64) std::atomic<uint64_t> head_{0};
+        alignas(64) std::atomic<uint64_t> tail_{0};
+        std::array<Record, kCapacity> records_{};
+    };
+
+    // Asynchronous logger: the calling thread only copies its arguments into its own ring,
+    // a background thread formats and writes the records. When a ring is full the record is dropped.
+    class AsyncLogger
+    {
+    public:
+        static AsyncLogger & Instance();
+
+        static void SetLevel(Level level) { level_.store(level, std::memory_order_relaxed); }
+        static bool IsEnabled(Level level) { return level >= level_.load(std::memory_order_relaxed); }
+
+        template <typename... Args>
+        void Log(Level level, const char * fmt, const Args&... args)
+        {
+            static_assert(sizeof...(Args) <= Record::kMaxArgs, "Too many log arguments");
+            auto & ring = ThreadRing();
+            auto * record = ring.TryClaim();
+            if (record == nullptr)
+            {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            record->timestamp_ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+            record->fmt = fmt;
+            record->level = level;
+            record->num_args = sizeof...(Args);
+            size_t i = 0;
+            (Capture(record->args[i++], args), ...);
+            ring.Publish();
+        }
+
+        // Block until every record published so far has been written
+        void Flush();
+        [[nodiscard]] uint64_t DroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+        ~AsyncLogger();
+
+    private:
+        AsyncLogger();
+
+        RecordRing & ThreadRing();
+        void Run();
+        size_t DrainAll();
+        static void Write(const Record & record, std::string & line);
+
+        template <typename T>
+        static void Capture(Arg & arg, const T & value)
+        {
+            using U = std::decay_t<T>;
+            if constexpr (std::is_same_v<U, bool>)
+            {
+                arg.kind = Arg::Kind::u64;
+                arg.u = value ? 1 : 0;
+            }
+            else if constexpr (std::is_enum_v<U>)
+                Capture(arg, static_cast<std::underlying_type_t<U>>(value));
+            else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>)
+            {
+                arg.kind = Arg::Kind::i64;
+                arg.i = value;
+            }
+            else if constexpr (std::is_integral_v<U>)
+            {
+                arg.kind = Arg::Kind::u64;
+                arg.u = value;
+            }
+            else if constexpr (std::is_floating_point_v<U>)
+            {
+                arg.kind = Arg::Kind::f64;
+                arg.d = value;
+            }
+            else
+            {
+                const std::string_view sv(value);
+                const size_t n = std::min(sv.size(), sizeof(arg.s) - 1);
+                arg.kind = Arg::Kind::str;
+                std::memcpy(arg.s, sv.data(), n);
+                arg.s[n] = '\0';
+            }
+        }
+
+        static inline std::atomic<Level> level_{Level::info};
+
+        std::mutex rings_mutex_;
+        std::vector<std::shared_ptr<RecordRing>> rings_;
+        std::atomic<uint64_t> dropped_{0};
+        std::atomic<uint64_t> flush_requests_{0};
+        std::atomic<uint64_t> flush_done_{0};
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cv_;
+        std::condition_variable flushed_cv_;
+        bool stopping_ = false;
+        std::thread worker_;
+    };
+}
+
+#define MES_LOG(level, ...) \
+    do { if (MESLog::AsyncLogger::IsEnabled(level)) MESLog::AsyncLogger::Instance().Log(level, __VA_ARGS__); } while (0)
+
+#if MES_LOG_COMPILE_LEVEL <= 0
+#define MES_LOG_DEBUG(...) MES_LOG(MESLog::Level::debug, __VA_ARGS__)
+#else
+#define MES_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if MES_LOG_COMPILE_LEVEL <= 1
+#define MES_LOG_INFO(...) MES_LOG(MESLog::Level::info, __VA_ARGS__)
+#else
+#define MES_LOG_INFO(...) ((void)0)
+#endif
+
+#if MES_LOG_COMPILE_LEVEL <= 2
+#define MES_LOG_WARN(...) MES_LOG(MESLog::Level::warn, __VA_ARGS__)
+#else
+#define MES_LOG_WARN(...) ((void)0)
+#endif
+
+#if MES_LOG_COMPILE_LEVEL <= 3
+#define MES_LOG_ERROR(...) MES_LOG(MESLog::Level::error, __VA_ARGS__)
+#else
+#define MES_LOG_ERROR(...) ((void)0)
+#endif
+
+#endif //RECONFIGMANUS_ASYNCLOGGER_H
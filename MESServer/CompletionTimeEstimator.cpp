@@ -0,0 +1,146 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "CompletionTimeEstimator.h"
+#include <algorithm>
+#include <map>
+#include "AsyncLogger.h"
+
+CompletionTimeEstimator::CompletionTimeEstimator(const GraphManager& graph_manager, const ProcessManager& process_manager,
+    const size_t num_threads, const uint32_t num_samples, const uint64_t seed)
+    : graph_manager_(graph_manager), process_manager_(process_manager),
+      pool_(std::make_unique<ThreadPool>(num_threads)), num_samples_(std::max(1u, num_samples)), seed_(seed)
+{
+}
+
+bool CompletionTimeEstimator::Quote(const ST_CompletionQuery& query, ST_CompletionQuote& out)
+{
+    QuoteBatch(std::span(&query, 1), std::span(&out, 1));
+    return out.valid;
+}
+
+void CompletionTimeEstimator::QuoteBatch(std::span<const ST_CompletionQuery> queries, std::span<ST_CompletionQuote> out)
+{
+    if (out.size() < queries.size())
+    {
+        MES_LOG_ERROR("[ETA] Output span smaller than the query batch");
+        return;
+    }
+
+    // Orders of a backlog mostly share their position and progress, sample each distinct route once
+    std::map<std::pair<uint32_t, std::vector<ST_ProcessInfo>>, size_t> unique_index;
+    std::vector<size_t> query_to_unique(queries.size());
+    std::vector<const ST_CompletionQuery *> unique_queries;
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        auto [it, inserted] = unique_index.try_emplace(
+            {queries[i].current_station, queries[i].remaining_processes}, unique_queries.size());
+        if (inserted)
+            unique_queries.push_back(&queries[i]);
+        query_to_unique[i] = it->second;
+    }
+
+    // Routes are planned up front, the graph is only read here and not from the workers
+    std::vector<std::vector<ST_TimeDist>> routes(unique_queries.size());
+    std::vector<ST_CompletionQuote> quotes(unique_queries.size());
+    std::vector<uint8_t> planned(unique_queries.size(), 0);
+    for (size_t u = 0; u < unique_queries.size(); ++u)
+        planned[u] = PlanRoute(*unique_queries[u], routes[u]) ? 1 : 0;
+
+    // The stream depends only on the position of the route in the batch, so quotes are reproducible
+    pool_->ParallelFor(unique_queries.size(), [&](const size_t u) {
+        if (planned[u])
+            SampleRoute(routes[u], u, quotes[u]);
+    });
+
+    for (size_t i = 0; i < queries.size(); ++i)
+        out[i] = quotes[query_to_unique[i]];
+}
+
+bool CompletionTimeEstimator::ExpectedRouteTime(const ST_CompletionQuery& query, double& out) const
+{
+    std::vector<ST_TimeDist> steps;
+    if (!PlanRoute(query, steps))
+        return false;
+    out = 0.0;
+    for (const auto & step : steps)
+        out += step.expected_value();
+    return true;
+}
+
+bool CompletionTimeEstimator::PlanRoute(const ST_CompletionQuery& query, std::vector<ST_TimeDist>& out_steps) const
+{
+    out_steps.clear();
+    uint32_t current = query.current_station;
+    std::vector<uint32_t> path;
+    for (const auto & process : query.remaining_processes)
+    {
+        const auto * stations = process_manager_.GetStationsForProcess(process);
+        if (stations == nullptr)
+            return false;
+
+        uint32_t target = current;
+        if (std::ranges::find(*stations, current) == stations->end())
+        {
+            // Same choice of process station as MESCore::PlanRouteToProcessStation
+            uint32_t next = UINT32_MAX;
+            float cost = 0.0f;
+            float length = 0.0f;
+            if (!graph_manager_.FindLeastCongestedVertex(current, *stations, target, next, cost)
+                || !graph_manager_.FindShortestPath(current, target, path, length))
+            {
+                MES_LOG_ERROR("[ETA] No route from station {} for process {}", current, process);
+                return false;
+            }
+            for (size_t i = 1; i < path.size(); ++i)
+            {
+                if (!graph_manager_.GetArcTimeDist(path[i - 1], path[i], out_steps.emplace_back()))
+                    return false;
+            }
+        }
+
+        if (!graph_manager_.GetVertexTimeDist(target, out_steps.emplace_back()))
+            return false;
+        current = target;
+    }
+    return true;
+}
+
+void CompletionTimeEstimator::SampleRoute(const std::vector<ST_TimeDist>& steps, const uint64_t stream,
+    ST_CompletionQuote& out) const
+{
+    // Per-thread buffers, sized once per thread
+    thread_local std::vector<double> totals;
+    thread_local std::vector<double> samples;
+    totals.assign(num_samples_, 0.0);
+    samples.resize(num_samples_);
+
+    PhiloxEngine rng(seed_, stream);
+    for (const auto & step : steps)
+    {
+        step.generate_times(samples, rng);
+        for (size_t i = 0; i < totals.size(); ++i)
+            totals[i] += samples[i];
+    }
+
+    double sum = 0.0;
+    for (const double t : totals)
+        sum += t;
+    out.mean = sum / static_cast<double>(totals.size());
+
+    // Successive partial selections, each quantile only searches the part above the previous one
+    const auto select = [&](const double q, const size_t from) {
+        const auto k = std::min(totals.size() - 1, static_cast<size_t>(q * static_cast<double>(totals.size())));
+        std::nth_element(totals.begin() + static_cast<std::ptrdiff_t>(std::min(from, k)),
+            totals.begin() + static_cast<std::ptrdiff_t>(k), totals.end());
+        return k;
+    };
+    const size_t k50 = select(0.50, 0);
+    out.p50 = totals[k50];
+    const size_t k95 = select(0.95, k50);
+    out.p95 = totals[k95];
+    const size_t k99 = select(0.99, k95);
+    out.p99 = totals[k99];
+    out.valid = true;
+}
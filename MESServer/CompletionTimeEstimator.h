@@ -0,0 +1,58 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_COMPLETIONTIMEESTIMATOR_H
+#define RECONFIGMANUS_COMPLETIONTIMEESTIMATOR_H
+
+#include <memory>
+#include <span>
+#include <vector>
+#include "GraphManager.h"
+#include "ProcessManager.h"
+#include "ThreadPool.h"
+
+struct ST_CompletionQuery
+{
+    uint32_t current_station{};
+    std::vector<ST_ProcessInfo> remaining_processes;
+};
+
+struct ST_CompletionQuote
+{
+    bool valid{false};
+    double mean{};
+    double p50{};
+    double p95{};
+    double p99{};
+};
+
+// Monte Carlo estimate of the remaining completion time of orders.
+// The remaining processes are routed the way the MES would route them now, then the
+// transfer and service time distributions along that route are sampled and summed.
+class CompletionTimeEstimator
+{
+public:
+    CompletionTimeEstimator(const GraphManager & graph_manager, const ProcessManager & process_manager,
+        size_t num_threads, uint32_t num_samples, uint64_t seed);
+    ~CompletionTimeEstimator() = default;
+
+    bool Quote(const ST_CompletionQuery & query, ST_CompletionQuote & out);
+    // Quotes are computed in parallel, identical queries (same station and remaining processes) are sampled once
+    void QuoteBatch(std::span<const ST_CompletionQuery> queries, std::span<ST_CompletionQuote> out);
+    // Sum of the expected transfer and service times along the same route, without sampling
+    bool ExpectedRouteTime(const ST_CompletionQuery & query, double & out) const;
+
+private:
+    // Time distributions of every transfer and service step left for the query, in route order
+    bool PlanRoute(const ST_CompletionQuery & query, std::vector<ST_TimeDist> & out_steps) const;
+    void SampleRoute(const std::vector<ST_TimeDist> & steps, uint64_t stream, ST_CompletionQuote & out) const;
+
+    const GraphManager & graph_manager_;
+    const ProcessManager & process_manager_;
+    std::unique_ptr<ThreadPool> pool_;
+    uint32_t num_samples_;
+    uint64_t seed_;
+};
+
+#endif //RECONFIGMANUS_COMPLETIONTIMEESTIMATOR_H
@@ -0,0 +1,164 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "CustomerOrderQueue.h"
+#include <algorithm>
+#include <bit>
+
+bool DispatchRuleFromString(const std::string & s, DispatchRule & out) noexcept
+{
+    if (s == "edd") out = DispatchRule::edd;
+    else if (s == "spt") out = DispatchRule::spt;
+    else if (s == "critical_ratio") out = DispatchRule::critical_ratio;
+    else return false;
+    return true;
+}
+
+const char * DispatchRuleToString(const DispatchRule r) noexcept
+{
+    switch (r)
+    {
+        case DispatchRule::spt: return "spt";
+        case DispatchRule::critical_ratio: return "critical_ratio";
+        default: return "edd";
+    }
+}
+
+CustomerOrderQueue::CustomerOrderQueue(const DispatchRule rule) : rule_(rule)
+{
+}
+
+void CustomerOrderQueue::SetExpectedRouteTime(const uint8_t product_type, const double time)
+{
+    expected_route_times_[product_type] = time;
+}
+
+bool CustomerOrderQueue::Push(const ST_CustomerOrder& order)
+{
+    if (positions_.contains(order.order_id))
+        return false;
+    auto & heap = heaps_[order.product_type];
+    const auto index = static_cast<uint32_t>(heap.size());
+    positions_[order.order_id] = {order.product_type, index};
+    heap.push_back(order);
+    Restore(heap, index);
+    pending_products_[order.product_type / 64] |= uint64_t{1} << (order.product_type % 64);
+    return true;
+}
+
+bool CustomerOrderQueue::Pop(const double now, ST_CustomerOrder& out, const ProductTypeSet * admitted)
+{
+    const ST_CustomerOrder * best = nullptr;
+    double best_key = 0.0;
+    for (uint32_t word = 0; word < pending_products_.size(); ++word)
+    {
+        for (auto bits = pending_products_[word]; bits != 0; bits &= bits - 1)
+        {
+            const auto product_type = word * 64 + std::countr_zero(bits);
+            if (admitted != nullptr && !admitted->test(product_type))
+                continue;
+            const auto & top = heaps_[product_type].front();
+            const double key = RuleKey(top, now);
+            if (best == nullptr || top.priority > best->priority ||
+                (top.priority == best->priority && (key < best_key || (key == best_key && Before(top, *best)))))
+            {
+                best = &top;
+                best_key = key;
+            }
+        }
+    }
+    if (best == nullptr)
+        return false;
+    out = *best;
+    EraseAt(out.product_type, 0);
+    return true;
+}
+
+bool CustomerOrderQueue::Remove(const uint32_t order_id)
+{
+    const auto it = positions_.find(order_id);
+    if (it == positions_.end())
+        return false;
+    EraseAt(it->second.product_type, it->second.index);
+    return true;
+}
+
+bool CustomerOrderQueue::Update(const uint32_t order_id, const uint8_t priority, const double due_time)
+{
+    const auto it = positions_.find(order_id);
+    if (it == positions_.end())
+        return false;
+    auto & heap = heaps_[it->second.product_type];
+    auto & entry = heap[it->second.index];
+    entry.priority = priority;
+    entry.due_time = due_time;
+    Restore(heap, it->second.index);
+    return true;
+}
+
+bool CustomerOrderQueue::Before(const ST_CustomerOrder& a, const ST_CustomerOrder& b)
+{
+    if (a.priority != b.priority)
+        return a.priority > b.priority;
+    if (a.due_time != b.due_time)
+        return a.due_time < b.due_time;
+    return a.order_id < b.order_id;
+}
+
+double CustomerOrderQueue::RuleKey(const ST_CustomerOrder& order, const double now) const
+{
+    switch (rule_)
+    {
+        case DispatchRule::spt:
+            return expected_route_times_[order.product_type];
+        case DispatchRule::critical_ratio:
+            // Late orders have a negative ratio and go first
+            return (order.due_time - now) / std::max(expected_route_times_[order.product_type], 1e-9);
+        default:
+            return order.due_time;
+    }
+}
+
+void CustomerOrderQueue::Place(std::vector<ST_CustomerOrder>& heap, const uint32_t index, const ST_CustomerOrder& order)
+{
+    heap[index] = order;
+    positions_[order.order_id].index = index;
+}
+
+void CustomerOrderQueue::Restore(std::vector<ST_CustomerOrder>& heap, uint32_t index)
+{
+    const auto order = heap[index];
+    // Up while before the parent, otherwise down while a child is before it
+    while (index > 0 && Before(order, heap[(index - 1) / 2]))
+    {
+        Place(heap, index, heap[(index - 1) / 2]);
+        index = (index - 1) / 2;
+    }
+    const auto size = static_cast<uint32_t>(heap.size());
+    for (uint32_t child = 2 * index + 1; child < size; child = 2 * index + 1)
+    {
+        if (child + 1 < size && Before(heap[child + 1], heap[child]))
+            ++child;
+        if (!Before(heap[child], order))
+            break;
+        Place(heap, index, heap[child]);
+        index = child;
+    }
+    Place(heap, index, order);
+}
+
+void CustomerOrderQueue::EraseAt(const uint8_t product_type, const uint32_t index)
+{
+    auto & heap = heaps_[product_type];
+    positions_.erase(heap[index].order_id);
+    const auto last = heap.back();
+    heap.pop_back();
+    if (index < heap.size())
+    {
+        heap[index] = last;
+        Restore(heap, index);
+    }
+    if (heap.empty())
+        pending_products_[product_type / 64] &= ~(uint64_t{1} << (product_type % 64));
+}
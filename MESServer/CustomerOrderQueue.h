@@ -0,0 +1,81 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_CUSTOMERORDERQUEUE_H
+#define RECONFIGMANUS_CUSTOMERORDERQUEUE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ProductMix.h"
+
+enum class DispatchRule : uint8_t
+{
+    edd,                // earliest due date
+    spt,                // shortest expected route time of the product
+    critical_ratio      // smallest (due time - now) / expected route time
+};
+
+// False for an unknown name, out is left unchanged
+bool DispatchRuleFromString(const std::string & s, DispatchRule & out) noexcept;
+const char * DispatchRuleToString(DispatchRule r) noexcept;
+
+// Times are on the MES clock, in graph time units
+struct ST_CustomerOrder
+{
+    uint32_t order_id;
+    uint8_t product_type;
+    uint8_t priority;       // higher priorities are always dispatched first
+    double due_time;
+};
+
+// Pending customer orders, one indexed binary heap per product type. Within a product every rule
+// reduces to (priority, due time), so only the heap tops are compared under the dispatch rule.
+// Push, Remove and Update are O(log N), Pop is O(log N + P) for P product types with pending orders.
+// Not thread-safe, OrderManager calls it under its lock.
+class CustomerOrderQueue
+{
+public:
+    explicit CustomerOrderQueue(DispatchRule rule = DispatchRule::edd);
+
+    [[nodiscard]] DispatchRule GetRule() const { return rule_; }
+    // Expected route time of a product from the order assigning station, used by SPT and critical ratio
+    void SetExpectedRouteTime(uint8_t product_type, double time);
+
+    // False if the order is already queued
+    bool Push(const ST_CustomerOrder & order);
+    // Takes the next order to release under the dispatch rule, false if none is pending.
+    // With admitted given, orders of other product types are passed over.
+    bool Pop(double now, ST_CustomerOrder & out, const ProductTypeSet * admitted = nullptr);
+    bool Remove(uint32_t order_id);
+    bool Update(uint32_t order_id, uint8_t priority, double due_time);
+
+    [[nodiscard]] size_t Size() const { return positions_.size(); }
+
+private:
+    static constexpr uint32_t kProductTypes = 256;
+
+    struct ST_HeapPosition
+    {
+        uint8_t product_type;
+        uint32_t index;
+    };
+
+    [[nodiscard]] static bool Before(const ST_CustomerOrder & a, const ST_CustomerOrder & b);
+    [[nodiscard]] double RuleKey(const ST_CustomerOrder & order, double now) const;
+    void Place(std::vector<ST_CustomerOrder> & heap, uint32_t index, const ST_CustomerOrder & order);
+    // Moves the entry at index to its place in the heap
+    void Restore(std::vector<ST_CustomerOrder> & heap, uint32_t index);
+    void EraseAt(uint8_t product_type, uint32_t index);
+
+    DispatchRule rule_;
+    std::array<std::vector<ST_CustomerOrder>, kProductTypes> heaps_;
+    std::array<double, kProductTypes> expected_route_times_{};
+    std::array<uint64_t, kProductTypes / 64> pending_products_{};   // bit per product type with a non-empty heap
+    std::unordered_map<uint32_t, ST_HeapPosition> positions_;       // by order ID
+};
+
+#endif //RECONFIGMANUS_CUSTOMERORDERQUEUE_H
@@ -5,9 +5,12 @@
 #ifndef RECONFIGMANUS_GRAPHDEF_H
 #define RECONFIGMANUS_GRAPHDEF_H
 
+#include <algorithm>
+#include <cmath>
+#include <span>
 #include <string>
 #include <vector>
-#include <random>
+#include "TimeSampling.h"
 
 
 enum TimeDistType
@@ -70,104 +73,71 @@ struct ST_TimeDist
     TimeDistType type{};
     std::vector<double> parameters;
 
+    // Single sample from the calling thread's sampling stream
     [[nodiscard]] double generate_time() const
     {
-        static std::random_device rd;
-        static std::mt19937 gen(rd()); // seed the generator (static so it's not reseeded every call)
+        double x = 0.0;
+        generate_times(std::span<double>(&x, 1), ThreadSamplingStream());
+        return x;
+    }
+
+    // Fill out with independent samples from the calling thread's sampling stream
+    void generate_times(std::span<double> out) const
+    {
+        generate_times(out, ThreadSamplingStream());
+    }
 
+    // Fill out with independent samples from the given stream, for reproducible or parallel sampling
+    void generate_times(std::span<double> out, PhiloxEngine & rng) const
+    {
         switch (type)
         {
             case TimeDistType::normal:
-            {
                 if (parameters.size() >= 2)
-                {
-                    std::normal_distribution<double> d(parameters[0], parameters[1]);
-                    const double x = d(gen);
-                    return x > 0 ? x : 0.0;
-                }
-                return 0.0;
-            }
+                    return TimeSampling::Normal(parameters[0], parameters[1], out, rng);
+                break;
             case TimeDistType::uniform:
-            {
                 if (parameters.size() >= 2)
                 {
                     double a = parameters[0];
                     double b = parameters[1];
                     if (b < a) std::swap(a, b);
                     if (a < b)
-                    {
-                        std::uniform_real_distribution<double> d(a, b);
-                        const double x = d(gen);
-                        return x > 0 ? x : 0.0;
-                    }
+                        return TimeSampling::Uniform(a, b, out, rng);
                 }
-                return 0.0;
-            }
+                break;
             case TimeDistType::exponential:
-            {
-                if (parameters.size() >= 1)
-                {
-                    const double lambda = parameters[0];
-                    if (lambda > 0)
-                    {
-                        std::exponential_distribution<double> d(lambda);
-                        const double x = d(gen);
-                        return x > 0 ? x : 0.0;
-                    }
-                }
-                return 0.0;
-            }
+                if (!parameters.empty() && parameters[0] > 0)
+                    return TimeSampling::Exponential(parameters[0], out, rng);
+                break;
             case TimeDistType::constant:
-            {
                 if (!parameters.empty())
                 {
-                    const double x = parameters[0];
-                    return x > 0 ? x : 0.0;
+                    std::ranges::fill(out, parameters[0] > 0 ? parameters[0] : 0.0);
+                    return;
                 }
-                return 0.0;
-            }
+                break;
             case TimeDistType::triangular:
-            {
                 if (parameters.size() >= 3)
                 {
                     double a = parameters[0];
                     double b = parameters[1];
                     double c = parameters[2];
                     if (b < a) std::swap(a, b);
-                    if (!(a < b)) return 0.0;
+                    if (!(a < b)) break;
                     if (c < a) c = a;
                     if (c > b) c = b;
-
-                    std::uniform_real_distribution<double> U(0.0, 1.0);
-                    const double u = U(gen);
-                    const double Fc = (c - a) / (b - a);
-                    double x;
-                    if (u < Fc)
-                        x = a + std::sqrt(u * (b - a) * (c - a));
-                    else
-                        x = b - std::sqrt((1.0 - u) * (b - a) * (b - c));
-                    return x > 0 ? x : 0.0;
+                    return TimeSampling::Triangular(a, b, c, out, rng);
                 }
-                return 0.0;
-            }
+                break;
             case TimeDistType::weibull:
-            {
-                if (parameters.size() >= 2)
-                {
-                    const double k = parameters[0];
-                    const double lambda = parameters[1];
-                    if (k > 0 && lambda > 0)
-                    {
-                        std::weibull_distribution<double> d(k, lambda);
-                        const double x = d(gen);
-                        return x > 0 ? x : 0.0;
-                    }
-                }
-                return 0.0;
-            }
+                if (parameters.size() >= 2 && parameters[0] > 0 && parameters[1] > 0)
+                    return TimeSampling::Weibull(parameters[0], parameters[1], out, rng);
+                break;
             default:
-                return 0.0;
+                break;
         }
+        std::ranges::fill(out, 0.0);
     }
 
     // for deterministic algorithms
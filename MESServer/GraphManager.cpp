@@ -6,12 +6,12 @@
 #include <fstream>
 #include <iomanip>
 #include <limits>
+#include <mutex>
 #include <algorithm>
-#include <unordered_set>
-#include <boost/property_map/function_property_map.hpp>
-#include <boost/graph/dijkstra_shortest_paths.hpp>
 #include <boost/graph/graphviz.hpp>
 #include "LogMacros.h"
+#include "AsyncLogger.h"
+#include "Metrics.h"
 
 
 GraphManager::GraphManager(const json & graph_model)
@@ -32,9 +32,17 @@ GraphManager::GraphManager(const json & graph_model)
         }
         v["service_time_distribution"]["parameters"].get_to(vertex_label.service_time_dist.parameters);
 
-        auto vertex_descriptor = boost::add_vertex(vertex_label, *graph_);
-        vertex_map_[vertex_label.id] = vertex_descriptor;
+        // npos marks unused entries of the index and unreachable hops, it cannot be a station ID
+        const auto id = vertex_label.id;
+        if (id >= RoutingGraph::npos)
+        {
+            std::cout << "Failed to add vertex, ID " << id << " out of range" << std::endl;
+            continue;
+        }
+        boost::add_vertex(std::move(vertex_label), *graph_);
+        vertex_ids_.push_back(id);
     }
+    BuildVertexIndex();
     for (const auto & a : graph_model["arcs"])
     {
         ST_ArcLabel arc_label{};
@@ -47,172 +55,200 @@ GraphManager::GraphManager(const json & graph_model)
         }
         a["transfer_time_distribution"]["parameters"].get_to(arc_label.transfer_time_dist.parameters);
 
-        auto [edge_descriptor, success] = boost::add_edge(vertex_map_[arc_label.tail],
-            vertex_map_[arc_label.head], arc_label, *graph_);
+        VertexDescriptor tail, head;
+        if (!FindVertex(arc_label.tail, tail) || !FindVertex(arc_label.head, head))
+        {
+            std::cout << "Failed to add arc, unknown vertex" << std::endl;
+            break;
+        }
+        auto [edge_descriptor, success] = boost::add_edge(tail, head, std::move(arc_label), *graph_);
         if (!success)
         {
             std::cout << "Failed to add arc" << std::endl;
-            return;
+            break;
         }
     }
+    RebuildRoutingGraph();
+}
+
+void GraphManager::BuildVertexIndex()
+{
+    // Dense array while the largest ID stays close to the vertex count, a hash map for sparse IDs
+    const auto max_id = vertex_ids_.empty() ? 0u : *std::max_element(vertex_ids_.begin(), vertex_ids_.end());
+    const bool dense = static_cast<uint64_t>(max_id) < kMaxDenseIdFactor * std::max<uint64_t>(vertex_ids_.size(), 1);
+    if (dense)
+        vertex_index_.assign(static_cast<size_t>(max_id) + 1, RoutingGraph::npos);
+    for (uint32_t v = 0; v < vertex_ids_.size(); ++v)
+    {
+        if (dense)
+            vertex_index_[vertex_ids_[v]] = v;
+        else
+            sparse_vertex_index_[vertex_ids_[v]] = v;
+    }
+}
+
+const ST_VertexLabel * GraphManager::GetVertexLabel(uint32_t id) const
+{
+    VertexDescriptor v;
+    if (!FindVertex(id, v))
+        return nullptr;
+    return &(*graph_)[v];
+}
+
+const ST_ArcLabel * GraphManager::GetArcLabel(uint32_t tail, uint32_t head) const
+{
+    EdgeDescriptor e;
+    if (!FindArc(tail, head, e))
+        return nullptr;
+    return &(*graph_)[e];
+}
+
+bool GraphManager::FindArc(uint32_t tail, uint32_t head, EdgeDescriptor& out) const
+{
+    VertexDescriptor vt, vh;
+    if (!FindVertex(tail, vt) || !FindVertex(head, vh))
+        return false;
+
+    auto [e, found] = boost::edge(vt, vh, *graph_);
+    if (!found)
+        return false;
+    out = e;
+    return true;
 }
 
 bool GraphManager::GetVertexProperties(uint32_t id, ST_VertexLabel& label) const
 {
-    auto it = vertex_map_.find(id);
-    if (it == vertex_map_.end())
+    std::shared_lock lock(mutex_);
+    const auto * vertex_label = GetVertexLabel(id);
+    if (vertex_label == nullptr)
         return false;
 
-    label = (*graph_)[it->second];
+    label = *vertex_label;
     return true;
 }
 
 bool GraphManager::GetVertexRole(uint32_t id, VertexRole& role) const
 {
-    auto it = vertex_map_.find(id);
-    if (it == vertex_map_.end())
+    const auto * vertex_label = GetVertexLabel(id);
+    if (vertex_label == nullptr)
         return false;
 
-    role = (*graph_)[it->second].role;
+    role = vertex_label->role;
     return true;
 }
 
 bool GraphManager::GetVertexTimeDist(uint32_t id, ST_TimeDist& dist) const
 {
-    auto it = vertex_map_.find(id);
-    if (it == vertex_map_.end())
+    std::shared_lock lock(mutex_);
+    const auto * vertex_label = GetVertexLabel(id);
+    if (vertex_label == nullptr)
         return false;
 
-    dist = (*graph_)[it->second].service_time_dist;
+    dist = vertex_label->service_time_dist;
     return true;
 }
 
 bool GraphManager::SetVertexTimeDist(uint32_t id, const ST_TimeDist& dist)
 {
-    auto it = vertex_map_.find(id);
-    if (it == vertex_map_.end())
+    std::unique_lock lock(mutex_);
+    VertexDescriptor v;
+    if (!FindVertex(id, v))
         return false;
 
-    (*graph_)[it->second].service_time_dist = dist;
+    (*graph_)[v].service_time_dist = dist;
+    vertex_service_means_[v] = dist.expected_value();
     return true;
 }
 
 bool GraphManager::GetArcProperties(uint32_t tail, uint32_t head, ST_ArcLabel& label) const
 {
-    auto itTail = vertex_map_.find(tail);
-    auto itHead = vertex_map_.find(head);
-    if (itTail == vertex_map_.end() || itHead == vertex_map_.end())
-        return false;
-
-    auto [e, found] = boost::edge(itTail->second, itHead->second, *graph_);
-    if (!found)
+    std::shared_lock lock(mutex_);
+    const auto * arc_label = GetArcLabel(tail, head);
+    if (arc_label == nullptr)
         return false;
 
-    label = (*graph_)[e];
+    label = *arc_label;
     return true;
 }
 
 bool GraphManager::GetArcTimeDist(uint32_t tail, uint32_t head, ST_TimeDist& dist) const
 {
-    auto itTail = vertex_map_.find(tail);
-    auto itHead = vertex_map_.find(head);
-    if (itTail == vertex_map_.end() || itHead == vertex_map_.end())
+    std::shared_lock lock(mutex_);
+    const auto * arc_label = GetArcLabel(tail, head);
+    if (arc_label == nullptr)
         return false;
 
-    auto [e, found] = boost::edge(itTail->second, itHead->second, *graph_);
-    if (!found)
-        return false;
-
-    dist = (*graph_)[e].transfer_time_dist;
+    dist = arc_label->transfer_time_dist;
     return true;
 }
 
 bool GraphManager::SetArcTimeDist(uint32_t tail, uint32_t head, const ST_TimeDist& dist)
 {
-    auto itTail = vertex_map_.find(tail);
-    auto itHead = vertex_map_.find(head);
-    if (itTail == vertex_map_.end() || itHead == vertex_map_.end())
-        return false;
-
-    auto [e, found] = boost::edge(itTail->second, itHead->second, *graph_);
-    if (!found)
+    std::unique_lock lock(mutex_);
+    EdgeDescriptor e;
+    if (!FindArc(tail, head, e))
         return false;
 
     (*graph_)[e].transfer_time_dist = dist;
+    routing_.SetArcWeight(boost::source(e, *graph_), boost::target(e, *graph_), dist.expected_value());
+    routing_.RepairTable();
     return true;
 }
 
-bool GraphManager::GetOutgoingNeighborVertices(uint32_t vertex_id, std::list<uint32_t>& out_vertices) const
+std::span<const uint32_t> GraphManager::GetOutgoingNeighborVertices(uint32_t vertex_id) const
 {
-    out_vertices.clear();
-    auto it = vertex_map_.find(vertex_id);
-    if (it == vertex_map_.end() || !graph_)
-        return false;
+    VertexDescriptor v;
+    if (!FindVertex(vertex_id, v))
+        return {};
 
-    using Graph = LabelledDiGraph;
-    using vertex_descriptor = boost::graph_traits<Graph>::vertex_descriptor;
-
-    const vertex_descriptor v = it->second;
-
-    // Collect only outgoing neighbors
-    auto adj_pair = boost::adjacent_vertices(v, *graph_);
-    for (auto ai = adj_pair.first; ai != adj_pair.second; ++ai)
-    {
-        out_vertices.push_back((*graph_)[*ai].id);
-    }
-
-    return !out_vertices.empty();
+    return std::span<const uint32_t>(out_neighbor_ids_).subspan(
+        out_neighbor_offsets_[v], out_neighbor_offsets_[v + 1] - out_neighbor_offsets_[v]);
 }
 
-bool GraphManager::GetIncomingNeighborVertices(uint32_t vertex_id, std::list<uint32_t>& out_vertices) const
+std::span<const uint32_t> GraphManager::GetIncomingNeighborVertices(uint32_t vertex_id) const
 {
-    out_vertices.clear();
-    auto it = vertex_map_.find(vertex_id);
-    if (it == vertex_map_.end() || !graph_)
-        return false;
+    VertexDescriptor v;
+    if (!FindVertex(vertex_id, v))
+        return {};
 
-    using Graph = LabelledDiGraph;
-    using vertex_descriptor = boost::graph_traits<Graph>::vertex_descriptor;
-
-    const vertex_descriptor v = it->second;
-
-    // Collect only incoming neighbors
-    auto inv_adj_pair = boost::inv_adjacent_vertices(v, *graph_);
-    for (auto ai = inv_adj_pair.first; ai != inv_adj_pair.second; ++ai)
-        out_vertices.push_back((*graph_)[*ai].id);
-
-    return !out_vertices.empty();
+    return std::span<const uint32_t>(in_neighbor_ids_).subspan(
+        in_neighbor_offsets_[v], in_neighbor_offsets_[v + 1] - in_neighbor_offsets_[v]);
 }
 
 void GraphManager::AddArcTimeDistWithVertexTimeDist(uint32_t tail, uint32_t head, uint32_t vertex_id, bool add_or_minus)
 {
-    if (!graph_) return;
+    std::unique_lock lock(mutex_);
+    if (ApplyVertexTimeDistToArc(tail, head, vertex_id, add_or_minus))
+        routing_.RepairTable();
+}
+
+bool GraphManager::ApplyVertexTimeDistToArc(uint32_t tail, uint32_t head, uint32_t vertex_id, bool add_or_minus)
+{
+    if (!graph_) return false;
 
     // Validate vertices exist
-    auto itTail = vertex_map_.find(tail);
-    auto itHead = vertex_map_.find(head);
-    auto itVtx  = vertex_map_.find(vertex_id);
-    if (itTail == vertex_map_.end() || itHead == vertex_map_.end() || itVtx == vertex_map_.end())
+    VertexDescriptor vt, vh, vv;
+    if (!FindVertex(tail, vt) || !FindVertex(head, vh) || !FindVertex(vertex_id, vv))
     {
-        ERROR_MSG("[GRAPH] Finding vertices failed");
-        return;
+        MES_LOG_ERROR("[GRAPH] Finding vertices failed");
+        return false;
     }
 
     // Validate arc exists
-    auto [e, found] = boost::edge(itTail->second, itHead->second, *graph_);
+    auto [e, found] = boost::edge(vt, vh, *graph_);
     if (!found)
     {
-        ERROR_MSG("[GRAPH] Finding arc failed");
-        return;
+        MES_LOG_ERROR("[GRAPH] Finding arc failed");
+        return false;
     }
 
     // TODO for now assume all normal distribution
     const auto & arc_dist = (*graph_)[e].transfer_time_dist;
-    const auto & vtx_dist = (*graph_)[itVtx->second].service_time_dist;
+    const auto & vtx_dist = (*graph_)[vv].service_time_dist;
     if (arc_dist.type != TimeDistType::normal || vtx_dist.type != TimeDistType::normal)
     {
-        ERROR_MSG("[GRAPH] Not normal distribution, setting Arc time dist failed");
-        return;
+        MES_LOG_ERROR("[GRAPH] Not normal distribution, setting Arc time dist failed");
+        return false;
     }
     
     ST_TimeDist new_dist;
@@ -221,93 +257,241 @@ void GraphManager::AddArcTimeDistWithVertexTimeDist(uint32_t tail, uint32_t head
     new_dist.parameters.emplace_back(sqrt(arc_dist.parameters[1] * arc_dist.parameters[1]
         + (add_or_minus ? 1 : -1) * vtx_dist.parameters[1] * vtx_dist.parameters[1]));
     
+    routing_.SetArcWeight(vt, vh, new_dist.expected_value());
     (*graph_)[e].transfer_time_dist = std::move(new_dist);
+    return true;
 }
 
 void GraphManager::AddTimeDistToAllPathsToVertex(uint32_t vertex_id, bool add_or_minus)
 {
+    std::unique_lock lock(mutex_);
     if (!graph_) return;
 
     // Validate vertex exists
-    auto it = vertex_map_.find(vertex_id);
-    if (it == vertex_map_.end())
+    const auto * vertex_label = GetVertexLabel(vertex_id);
+    if (vertex_label == nullptr)
         return;
 
-    const auto role = (*graph_)[it->second].role;
-
-    std::list<uint32_t> incoming_vertices;
-    if (!GetIncomingNeighborVertices(vertex_id, incoming_vertices))
+    const auto incoming_vertices = GetIncomingNeighborVertices(vertex_id);
+    if (incoming_vertices.empty())
     {
-        if (role != VertexRole::source)
-            ERROR_MSG("[GRAPH] No incoming neighbor vertices");
+        if (vertex_label->role != VertexRole::source)
+            MES_LOG_ERROR("[GRAPH] No incoming neighbor vertices");
         return;
     }
 
+    bool changed = false;
     for (const auto & in_vtx : incoming_vertices)
-        AddArcTimeDistWithVertexTimeDist(in_vtx, vertex_id, vertex_id, add_or_minus);
+        changed |= ApplyVertexTimeDistToArc(in_vtx, vertex_id, vertex_id, add_or_minus);
 
+    // Refresh routing once for the whole batch of arc updates
+    if (changed)
+    {
+        VertexDescriptor v;
+        if (FindVertex(vertex_id, v))
+        {
+            auto & inflated = vertex_inflated_trays_[v];
+            inflated = add_or_minus ? inflated + 1 : (inflated > 0 ? inflated - 1 : 0);
+        }
+        routing_.RepairTable();
+    }
+}
+
+void GraphManager::RebuildRoutingGraph()
+{
+    std::vector<ST_RoutingArc> arcs;
+    arcs.reserve(boost::num_edges(*graph_));
+    for (auto [ei, ei_end] = boost::edges(*graph_); ei != ei_end; ++ei)
+    {
+        arcs.push_back(ST_RoutingArc{
+            static_cast<uint32_t>(boost::source(*ei, *graph_)),
+            static_cast<uint32_t>(boost::target(*ei, *graph_)),
+            (*graph_)[*ei].transfer_time_dist.expected_value()
+        });
+    }
+    const auto n = static_cast<uint32_t>(boost::num_vertices(*graph_));
+    routing_.Build(n, arcs);
+
+    vertex_occupancy_ = std::vector<std::atomic<uint32_t>>(n);
+    vertex_inflated_trays_.assign(n, 0);
+    vertex_service_means_.resize(n);
+    for (VertexDescriptor v = 0; v < n; ++v)
+        vertex_service_means_[v] = (*graph_)[v].service_time_dist.expected_value();
+
+    // Neighbor arrays keep the adjacency list order, the first outgoing neighbor is the default route
+    out_neighbor_offsets_.assign(1, 0);
+    in_neighbor_offsets_.assign(1, 0);
+    out_neighbor_ids_.clear();
+    in_neighbor_ids_.clear();
+    for (VertexDescriptor v = 0; v < n; ++v)
+    {
+        for (auto [ai, ai_end] = boost::adjacent_vertices(v, *graph_); ai != ai_end; ++ai)
+            out_neighbor_ids_.push_back(vertex_ids_[*ai]);
+        for (auto [ai, ai_end] = boost::inv_adjacent_vertices(v, *graph_); ai != ai_end; ++ai)
+            in_neighbor_ids_.push_back(vertex_ids_[*ai]);
+        out_neighbor_offsets_.push_back(static_cast<uint32_t>(out_neighbor_ids_.size()));
+        in_neighbor_offsets_.push_back(static_cast<uint32_t>(in_neighbor_ids_.size()));
+    }
 }
 
 bool GraphManager::FindShortestPath(uint32_t tail, uint32_t head, std::vector<uint32_t>& out_path, float& out_length) const
 {
+    MES_METRIC_TIME_SCOPE("mes_shortest_path_seconds", "Time spent in GraphManager::FindShortestPath");
+    std::shared_lock lock(mutex_);
     // If head == tail, out_path contains only the same vertex, out_length is 0.0f
-    auto itTail = vertex_map_.find(tail);
-    auto itHead = vertex_map_.find(head);
-    if (itTail == vertex_map_.end() || itHead == vertex_map_.end())
+    VertexDescriptor vt, vh;
+    if (!FindVertex(tail, vt) || !FindVertex(head, vh))
         return false;
 
-    using Graph = LabelledDiGraph;
-    using vertex_descriptor = boost::graph_traits<Graph>::vertex_descriptor;
-    using edge_descriptor = boost::graph_traits<Graph>::edge_descriptor;
+    // Return false if unreachable
+    const auto h = static_cast<uint32_t>(vh);
+    const double length = routing_.Distance(static_cast<uint32_t>(vt), h);
+    if (!std::isfinite(length))
+        return false;
+
+    // Follow the first hops from tail to head
+    out_path.clear();
+    for (auto v = static_cast<uint32_t>(vt); ; )
+    {
+        out_path.push_back(vertex_ids_[v]);
+        if (v == h) break;
+        const auto nv = routing_.NextHop(v, h);
+        if (nv == v || nv == RoutingGraph::npos) break; // safety
+        v = nv;
+    }
 
-    const auto n = boost::num_vertices(*graph_);
-    if (n == 0)
+    out_length = static_cast<float>(length);
+    return true;
+}
+
+bool GraphManager::FindNextHop(uint32_t tail, uint32_t head, uint32_t& out_next, float& out_length) const
+{
+    std::shared_lock lock(mutex_);
+    // If head == tail, out_next is the same vertex, out_length is 0.0f
+    VertexDescriptor vt, vh;
+    if (!FindVertex(tail, vt) || !FindVertex(head, vh))
         return false;
 
-    const auto weight_map = boost::make_function_property_map<edge_descriptor, double>(
-        [this](const edge_descriptor& e) -> double {
-            const auto & transfer_dist = (*graph_)[e].transfer_time_dist;
-            return transfer_dist.expected_value();
-        }
-    );
+    const auto t = static_cast<uint32_t>(vt);
+    const auto h = static_cast<uint32_t>(vh);
+    const double length = routing_.Distance(t, h);
+    if (!std::isfinite(length))
+        return false;
 
-    std::vector<vertex_descriptor> pred(n);
-    std::vector<double> dist(n, std::numeric_limits<double>::infinity());
+    out_next = vertex_ids_[routing_.NextHop(t, h)];
+    out_length = static_cast<float>(length);
+    return true;
+}
 
-    auto index_map = get(boost::vertex_index, *graph_);
+bool GraphManager::FindNearestVertex(uint32_t tail, const std::vector<uint32_t>& candidates,
+    uint32_t& out_target, uint32_t& out_next, float& out_length) const
+{
+    std::shared_lock lock(mutex_);
+    // One pass over the candidates' routing table entries, no graph search needed
+    VertexDescriptor vt;
+    if (!FindVertex(tail, vt))
+        return false;
 
-    // Run Dijkstra from source
-    boost::dijkstra_shortest_paths(
-        *graph_,
-        itTail->second,
-        boost::weight_map(weight_map)
-            .distance_map(boost::make_iterator_property_map(dist.begin(), index_map))
-            .predecessor_map(boost::make_iterator_property_map(pred.begin(), index_map))
-    );
+    const auto t = static_cast<uint32_t>(vt);
+    double best_len = std::numeric_limits<double>::infinity();
+    uint32_t best_head = RoutingGraph::npos;
+    for (const auto candidate : candidates)
+    {
+        VertexDescriptor vh;
+        if (!FindVertex(candidate, vh))
+            continue;
+        const auto h = static_cast<uint32_t>(vh);
+        const double len = routing_.Distance(t, h);
+        if (len < best_len)
+        {
+            best_len = len;
+            best_head = h;
+        }
+    }
+    if (!std::isfinite(best_len))
+        return false; // none reachable
 
-    // Return false if unreachable
-    if (!std::isfinite(dist[index_map[itHead->second]]))
+    out_target = vertex_ids_[best_head];
+    out_next = vertex_ids_[routing_.NextHop(t, best_head)];
+    out_length = static_cast<float>(best_len);
+    return true;
+}
+
+bool GraphManager::FindLeastCongestedVertex(uint32_t tail, const std::vector<uint32_t>& candidates,
+    uint32_t& out_target, uint32_t& out_next, float& out_cost) const
+{
+    std::shared_lock lock(mutex_);
+    VertexDescriptor vt;
+    if (!FindVertex(tail, vt))
         return false;
 
-    // Reconstruct the path from head back to tail
-    std::vector<uint32_t> rev_path;
-    for (auto v = itHead->second; ; )
+    const auto t = static_cast<uint32_t>(vt);
+    // Candidates with free buffer space are preferred, full ones are only used when every candidate is full
+    double best_cost[2] = {std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()};
+    uint32_t best_head[2] = {RoutingGraph::npos, RoutingGraph::npos};
+    for (const auto candidate : candidates)
     {
-        rev_path.push_back((*graph_)[v].id);
-        if (v == itTail->second) break;
-        auto pv = pred[index_map[v]];
-        if (pv == v) break; // safety
-        v = pv;
+        VertexDescriptor vh;
+        if (!FindVertex(candidate, vh))
+            continue;
+        const auto h = static_cast<uint32_t>(vh);
+        const double len = routing_.Distance(t, h);
+        if (!std::isfinite(len))
+            continue;
+
+        // Trays in service are already in the live weights of the incoming arcs,
+        // every other tray at or heading to the candidate adds one expected service time
+        const uint32_t occupancy = vertex_occupancy_[h].load(std::memory_order_relaxed);
+        const uint32_t queued = occupancy - std::min(occupancy, vertex_inflated_trays_[h]);
+        const double waiting = queued * vertex_service_means_[h];
+        const int full = occupancy >= (*graph_)[vh].buffer_capacity ? 1 : 0;
+        const double cost = len + waiting;
+        if (cost < best_cost[full])
+        {
+            best_cost[full] = cost;
+            best_head[full] = h;
+        }
     }
-    std::ranges::reverse(rev_path);
+    const int tier = best_head[0] != RoutingGraph::npos ? 0 : 1;
+    if (best_head[tier] == RoutingGraph::npos)
+        return false; // none reachable
 
-    out_path = std::move(rev_path);
-    out_length = static_cast<float>(dist[index_map[itHead->second]]);
+    out_target = vertex_ids_[best_head[tier]];
+    out_next = vertex_ids_[routing_.NextHop(t, best_head[tier])];
+    out_cost = static_cast<float>(best_cost[tier]);
     return true;
 }
 
+void GraphManager::OnTrayArrived(uint32_t vertex_id)
+{
+    VertexDescriptor v;
+    if (!FindVertex(vertex_id, v))
+        return;
+    vertex_occupancy_[v].fetch_add(1, std::memory_order_relaxed);
+}
+
+void GraphManager::OnTrayDeparted(uint32_t vertex_id)
+{
+    VertexDescriptor v;
+    if (!FindVertex(vertex_id, v))
+        return;
+    auto & occupancy = vertex_occupancy_[v];
+    uint32_t cur = occupancy.load(std::memory_order_relaxed);
+    while (cur > 0 && !occupancy.compare_exchange_weak(cur, cur - 1, std::memory_order_relaxed))
+        ;
+}
+
+uint32_t GraphManager::GetVertexOccupancy(uint32_t vertex_id) const
+{
+    VertexDescriptor v;
+    if (!FindVertex(vertex_id, v))
+        return 0;
+    return vertex_occupancy_[v].load(std::memory_order_relaxed);
+}
+
 void GraphManager::WriteOutDotFile(const std::string& filename, bool symbolic) const
 {
+    std::shared_lock lock(mutex_);
     std::ofstream out(filename);
     if (!out.is_open())
     {
@@ -6,11 +6,16 @@
 #define RECONFIGMANUS_LABELLEDDIGRAPH_H
 
 #include "GraphDef.h"
+#include "RoutingGraph.h"
 #include <nlohmann/json.hpp>
 #include <boost/graph/graph_traits.hpp>
 #include <boost/graph/adjacency_list.hpp>
-#include <list>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
+#include <span>
 #include <unordered_map>
+#include <vector>
 
 using json = nlohmann::json;
 
@@ -22,6 +27,10 @@ using LabelledDiGraph = boost::adjacency_list<
         ST_ArcLabel
 >;
 
+// Thread-safe: time distributions, routing and occupancy may be queried while other threads update them.
+// Topology, IDs, names, roles and buffer capacities are immutable after construction, so the label
+// pointers and neighbor spans can be read without locking; their time distributions cannot, use the
+// copying getters for those when updates may run concurrently.
 class GraphManager
 {
 public:
@@ -29,6 +38,10 @@ public:
 
     ~GraphManager() = default;
 
+    // Non-copying accessors, nullptr if the vertex or arc does not exist
+    const ST_VertexLabel * GetVertexLabel(uint32_t id) const;
+    const ST_ArcLabel * GetArcLabel(uint32_t tail, uint32_t head) const;
+
     bool GetVertexProperties(uint32_t id, ST_VertexLabel& label) const;
     bool GetVertexRole(uint32_t id, VertexRole& role) const;
     bool GetVertexTimeDist(uint32_t id, ST_TimeDist& dist) const;
@@ -38,22 +51,86 @@ public:
     bool GetArcTimeDist(uint32_t tail, uint32_t head, ST_TimeDist& dist) const;
     bool SetArcTimeDist(uint32_t tail, uint32_t head, const ST_TimeDist& dist);
 
-    bool GetOutgoingNeighborVertices(uint32_t vertex_id, std::list<uint32_t>& out_vertices) const;
-    bool GetIncomingNeighborVertices(uint32_t vertex_id, std::list<uint32_t>& out_vertices) const;
+    // Neighbor station IDs in arc insertion order, empty if the vertex does not exist
+    std::span<const uint32_t> GetOutgoingNeighborVertices(uint32_t vertex_id) const;
+    std::span<const uint32_t> GetIncomingNeighborVertices(uint32_t vertex_id) const;
 
     void AddArcTimeDistWithVertexTimeDist(uint32_t tail, uint32_t head, uint32_t vertex_id, bool add_or_minus = true);
     void AddTimeDistToAllPathsToVertex(uint32_t vertex_id, bool add_or_minus = true);
 
     bool FindShortestPath(uint32_t tail, uint32_t head, std::vector<uint32_t>& out_path, float & out_length) const;
+    bool FindNextHop(uint32_t tail, uint32_t head, uint32_t & out_next, float & out_length) const;
+    bool FindNearestVertex(uint32_t tail, const std::vector<uint32_t>& candidates,
+        uint32_t & out_target, uint32_t & out_next, float & out_length) const;
+    // Like FindNearestVertex, but also weighs the expected waiting time and remaining buffer of each candidate
+    bool FindLeastCongestedVertex(uint32_t tail, const std::vector<uint32_t>& candidates,
+        uint32_t & out_target, uint32_t & out_next, float & out_cost) const;
+
+    // Live buffer occupancy: trays at or committed to a vertex
+    void OnTrayArrived(uint32_t vertex_id);
+    void OnTrayDeparted(uint32_t vertex_id);
+    uint32_t GetVertexOccupancy(uint32_t vertex_id) const;
 
     void WriteOutDotFile(const std::string& filename, bool symbolic = false) const;
 
 
 private:
+    using VertexDescriptor = boost::graph_traits<LabelledDiGraph>::vertex_descriptor;
+    using EdgeDescriptor = boost::graph_traits<LabelledDiGraph>::edge_descriptor;
+
+    // Largest station ID, relative to the vertex count, still indexed by a flat array
+    static constexpr uint64_t kMaxDenseIdFactor = 64;
+
+    // Station ID to vertex descriptor through the dense index, or the sparse one if it is in use
+    bool FindVertex(uint32_t id, VertexDescriptor & out) const
+    {
+        if (!sparse_vertex_index_.empty())
+        {
+            const auto it = sparse_vertex_index_.find(id);
+            if (it == sparse_vertex_index_.end())
+                return false;
+            out = it->second;
+            return true;
+        }
+        if (id >= vertex_index_.size() || vertex_index_[id] == RoutingGraph::npos)
+            return false;
+        out = vertex_index_[id];
+        return true;
+    }
+    void BuildVertexIndex();
+    bool FindArc(uint32_t tail, uint32_t head, EdgeDescriptor & out) const;
+
+    // Regenerate the routing snapshot and neighbor arrays from the labelled graph
+    void RebuildRoutingGraph();
+    // Combine vertex service time into an arc transfer time without refreshing the routing table
+    bool ApplyVertexTimeDistToArc(uint32_t tail, uint32_t head, uint32_t vertex_id, bool add_or_minus);
+
     std::unique_ptr<LabelledDiGraph> graph_;
 
-    using VertexDescriptor = boost::graph_traits<LabelledDiGraph>::vertex_descriptor;
-    std::unordered_map<uint32_t, VertexDescriptor> vertex_map_;
+    // Dense ID remapping: station ID -> vertex descriptor (npos if unused), and back.
+    // Station IDs are small configured numbers, so a flat array sized by the largest ID is used. Models
+    // with IDs far above the vertex count use the hash map instead.
+    std::vector<uint32_t> vertex_index_;
+    std::unordered_map<uint32_t, uint32_t> sparse_vertex_index_;
+    std::vector<uint32_t> vertex_ids_;
+
+    // Neighbor station IDs in CSR layout, indexed by vertex descriptor
+    std::vector<uint32_t> out_neighbor_offsets_;
+    std::vector<uint32_t> out_neighbor_ids_;
+    std::vector<uint32_t> in_neighbor_offsets_;
+    std::vector<uint32_t> in_neighbor_ids_;
+
+    // Hot routing snapshot with all-pairs table, indexed by vertex descriptor
+    RoutingGraph routing_;
+
+    // Guards time distributions, arc weights and the routing table
+    mutable std::shared_mutex mutex_;
+
+    // Per vertex descriptor: live tray count, trays whose service time is added to the incoming arcs,
+    // and expected service time
+    std::vector<std::atomic<uint32_t>> vertex_occupancy_;
+    std::vector<uint32_t> vertex_inflated_trays_;
+    std::vector<double> vertex_service_means_;
 };
 
 #endif //RECONFIGMANUS_LABELLEDDIGRAPH_H
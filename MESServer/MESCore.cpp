@@ -0,0 +1,585 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "MESCore.h"
+#include "AsyncLogger.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+void ParseMESCoreOptions(const json& j_service, ST_MESCoreOptions& out)
+{
+    out.eta_threads = j_service.value("eta_threads", out.eta_threads);
+    out.eta_samples = j_service.value("eta_samples", out.eta_samples);
+    out.eta_seed = j_service.value("eta_seed", out.eta_seed);
+    out.max_trays = j_service.value("max_trays", out.max_trays);
+    out.route_push = j_service.value("route_push", out.route_push);
+    out.trace_events = j_service.value("trace_events", out.trace_events);
+    out.order_seed = j_service.value("order_seed", out.order_seed);
+    const auto release_policy = j_service.value("order_release_policy", std::string("weighted_random"));
+    if (!OrderReleasePolicyFromString(release_policy, out.order_release_policy))
+        throw std::invalid_argument("unknown mes_service.order_release_policy \"" + release_policy + "\"");
+    const auto dispatch_rule = j_service.value("dispatch_rule", std::string("edd"));
+    if (!DispatchRuleFromString(dispatch_rule, out.dispatch_rule))
+        throw std::invalid_argument("unknown mes_service.dispatch_rule \"" + dispatch_rule + "\"");
+    out.graph_time_per_second = j_service.value("graph_time_per_second", out.graph_time_per_second);
+    out.release_control = j_service.value("release_control", out.release_control);
+    out.release_adaptive = j_service.value("release_adaptive", out.release_adaptive);
+}
+
+MESCore::MESCore(const json& j_graph, const json& j_capabilities, const json& j_products,
+    const ST_MESCoreOptions& options)
+{
+    graph_manager_ = std::make_unique<GraphManager>(j_graph);
+    order_seed_ = options.order_seed != 0 ? options.order_seed
+        : (static_cast<uint64_t>(std::random_device{}()) << 32 | std::random_device{}());
+    order_manager_ = std::make_unique<OrderManager>(order_seed_, options.order_release_policy, options.dispatch_rule);
+    process_manager_ = std::make_unique<ProcessManager>(*order_manager_, j_capabilities, j_products);
+    completion_estimator_ = std::make_unique<CompletionTimeEstimator>(*graph_manager_, *process_manager_,
+        options.eta_threads, options.eta_samples, options.eta_seed);
+    tray_states_ = std::make_unique<TrayStateTable>(options.max_trays);
+    route_push_ = options.route_push;
+    MESTrace::Tracer::Instance().Enable(options.trace_events);
+    start_ns_ = MESMetrics::NowNs();
+    graph_time_per_second_ = options.graph_time_per_second;
+
+    // Expected route time of every product through the idle plant, for the dispatch rules and the WIP caps
+    std::vector<std::pair<uint8_t, double>> route_times;
+    for (const auto & [product_type, product] : process_manager_->products_)
+    {
+        double time;
+        if (completion_estimator_->ExpectedRouteTime({process_manager_->GetDefaultReturningStation(), product.processes}, time))
+        {
+            order_manager_->SetExpectedRouteTime(product_type, time);
+            route_times.emplace_back(product_type, time);
+        }
+    }
+    if (options.release_control)
+        SetupReleaseControl(options.release_adaptive, route_times);
+}
+
+void MESCore::SetupReleaseControl(const bool adaptive, const std::vector<std::pair<uint8_t, double>>& route_times)
+{
+    release_controller_ = std::make_unique<ReleaseController>(adaptive);
+    // Pool of every process: the service rates and buffers of the stations able to run it
+    for (const auto & [process, stations] : process_manager_->process_station_map_)
+    {
+        ST_ProcessPool pool;
+        pool.stations = static_cast<uint32_t>(stations.size());
+        for (const auto station : stations)
+        {
+            ST_TimeDist dist;
+            if (graph_manager_->GetVertexTimeDist(station, dist) && dist.expected_value() > 0.0)
+                pool.service_rate += 1.0 / dist.expected_value();
+            if (const auto * label = graph_manager_->GetVertexLabel(station))
+                pool.buffer_capacity += label->buffer_capacity;
+        }
+        release_controller_->SetProcessPool(process, pool);
+    }
+    for (const auto & [product_type, time] : route_times)
+        release_controller_->AddProduct(product_type, process_manager_->products_.at(product_type).processes, time);
+    for (const auto & [product_type, product] : process_manager_->products_)
+    {
+        if (std::none_of(route_times.begin(), route_times.end(), [&](const auto & route) { return route.first == product_type; }))
+            MES_LOG_ERROR("[RELEASE] Product type {} has no expected route time, its orders are released without a WIP cap",
+                product_type);
+    }
+}
+
+ST_StationActionRsp MESCore::AnswerStationQuery(const uint32_t msg_type, const ST_StationActionQuery& qry,
+    ST_StationRoutePush * out_push)
+{
+    if (msg_type == MSG_STATION_ACTION_DONE_QUERY)
+    {
+        MES_TRACE(done_query_received, qry.tray_id, UINT32_MAX, qry.workstation_id);
+        MES_LOG_INFO("[MES] Action done query received: workstation_id: {}, tray_id: {}", qry.workstation_id, qry.tray_id);
+        return OnStationActionDoneQuery(qry, out_push);
+    }
+    MES_TRACE(query_received, qry.tray_id, UINT32_MAX, qry.workstation_id);
+    MES_LOG_INFO("[MES] Action query received: workstation_id: {}, tray_id: {}", qry.workstation_id, qry.tray_id);
+    return OnStationActionQuery(qry, out_push);
+}
+
+void MESCore::AnswerStationQueries(const std::span<const ST_StationActionBatchItem> items, const std::span<ST_StationActionRsp> out,
+    const std::span<ST_StationRoutePush> out_pushes)
+{
+    const auto count = std::min(items.size(), out.size());
+    for (size_t i = 0; i < count; ++i)
+        out[i] = AnswerStationQuery(items[i].query_type, items[i].qry, i < out_pushes.size() ? &out_pushes[i] : nullptr);
+}
+
+ST_StationActionRsp MESCore::OnStationActionQuery(const ST_StationActionQuery& qry, ST_StationRoutePush * out_push)
+{
+    if (out_push != nullptr)
+        out_push->route_length = 0;
+    const auto tray_slot = tray_states_->Acquire(qry.tray_id);
+    if (tray_slot == TrayStateTable::npos)
+    {
+        // Reported once, the untracked trays keep querying for as long as they circulate
+        MES_METRIC_COUNT("mes_untracked_tray_queries_total", "Queries of trays beyond the tray state table capacity", "");
+        if (!tray_table_full_reported_.exchange(true, std::memory_order_relaxed))
+            MES_LOG_ERROR("[MES] Tray state table full ({} trays), tray {} and any further new trays are released "
+                "untracked and never get orders, raise mes_service.max_trays", tray_states_->Capacity(), qry.tray_id);
+        else
+            MES_LOG_DEBUG("[MES] Tray {} is released untracked", qry.tray_id);
+        return MakeDefaultReleaseRsp(tray_slot, qry);
+    }
+    return OnTrayAtStation(tray_slot, qry, out_push);
+}
+
+ST_StationActionRsp MESCore::OnTrayAtStation(const uint32_t tray_slot, const ST_StationActionQuery& qry,
+    ST_StationRoutePush * out_push)
+{
+    // Keep station occupancy in step with the tray movements seen by the MES
+    UpdateTrayStation(tray_slot, qry.workstation_id, TrayRouteState::at_station);
+    const auto previous_target = tray_states_->GetRouteTarget(tray_slot);
+    const auto rsp = DecideStationAction(tray_slot, qry);
+    RecordDecision(rsp, previous_target, tray_states_->GetRouteTarget(tray_slot));
+    if (rsp.action_type == 0)
+    {
+        // A tray following a pushed route only reports back at its target, so it is committed there directly
+        if (route_push_ && out_push != nullptr && BuildRoutePush(tray_slot, rsp, *out_push))
+            UpdateTrayStation(tray_slot, tray_states_->GetRouteTarget(tray_slot), TrayRouteState::in_transit);
+        else
+            UpdateTrayStation(tray_slot, rsp.next_station_id, TrayRouteState::in_transit);
+    }
+    else
+        UpdateTrayStation(tray_slot, qry.workstation_id, TrayRouteState::processing);
+    return rsp;
+}
+
+void MESCore::RecordDecision(const ST_StationActionRsp& rsp, const uint32_t previous_target, const uint32_t route_target)
+{
+    // A reroute sends a tray that was already heading for a process station to a different one
+    const auto next_station = rsp.action_type == 1 ? rsp.qry.workstation_id : rsp.next_station_id;
+    if (rsp.action_type == 1)
+    {
+        MES_METRIC_COUNT("mes_station_decisions_total", "Station action decisions by outcome", "outcome=\"execute\"");
+        MES_TRACE(decision_execute, rsp.qry.tray_id, rsp.order_id, rsp.qry.workstation_id, next_station);
+    }
+    else if (route_target == TrayStateTable::npos)
+    {
+        MES_METRIC_COUNT("mes_station_decisions_total", "Station action decisions by outcome", "outcome=\"default_release\"");
+        MES_TRACE(decision_default_release, rsp.qry.tray_id, rsp.order_id, rsp.qry.workstation_id, next_station);
+    }
+    else if (previous_target != TrayStateTable::npos && previous_target != route_target)
+    {
+        MES_METRIC_COUNT("mes_station_decisions_total", "Station action decisions by outcome", "outcome=\"reroute\"");
+        MES_TRACE(decision_reroute, rsp.qry.tray_id, rsp.order_id, rsp.qry.workstation_id, next_station);
+    }
+    else
+    {
+        MES_METRIC_COUNT("mes_station_decisions_total", "Station action decisions by outcome", "outcome=\"route\"");
+        MES_TRACE(decision_route, rsp.qry.tray_id, rsp.order_id, rsp.qry.workstation_id, next_station);
+    }
+}
+
+ST_StationActionRsp MESCore::MakeDefaultReleaseRsp(const uint32_t tray_slot, const ST_StationActionQuery& qry) const
+{
+    ST_StationActionRsp rsp;
+    rsp.qry = qry;
+    // Set order_id based on whether the tray has an executing order
+    rsp.order_id = tray_slot != TrayStateTable::npos ? tray_states_->GetOrderId(tray_slot) : UINT32_MAX;
+    rsp.action_type = 0;    // Default action: release
+    rsp.next_station_id = CalculateDefaultNextStation(qry.workstation_id);
+    return rsp;
+}
+
+ST_StationActionRsp MESCore::DecideStationAction(const uint32_t tray_slot, const ST_StationActionQuery& qry)
+{
+    // Construct default releasing response
+    auto rsp = MakeDefaultReleaseRsp(tray_slot, qry);
+    tray_states_->SetRouteTarget(tray_slot, TrayStateTable::npos);
+
+    if (!tray_states_->IsExecutingOrder(tray_slot))
+    {
+        // Try assigning order to the tray only if at order assigning station
+        if (process_manager_->IsOrderAssigningStation(qry.workstation_id))
+        {
+            // if no order waiting, release
+            if (order_manager_->GetWaitOrderNum() == 0)
+            {
+                MES_LOG_INFO("[MES] No order waiting, default release.");
+                return rsp;
+            }
+            // Else there are orders waiting, try assign within the WIP caps
+            ProductTypeSet admitted;
+            if (release_controller_ != nullptr)
+            {
+                release_controller_->GetAdmittedProducts(admitted);
+                if (admitted.none())
+                {
+                    MES_METRIC_COUNT("mes_release_held_total", "Empty trays released because every product is at its WIP cap", "");
+                    MES_LOG_INFO("[MES] WIP caps reached, default release.");
+                    return rsp;
+                }
+            }
+            uint32_t order_id;
+            if (!order_manager_->TryAssignNewOrderToTray(qry.tray_id, order_id, Now(),
+                release_controller_ != nullptr ? &admitted : nullptr))
+            {
+                // Assigning failed, release
+                MES_LOG_INFO("[MES] Assigning order failed, default release.");
+                return rsp;
+            }
+            // Else assigning success
+            tray_states_->SetOrderId(tray_slot, order_id);
+            rsp.order_id = order_id;
+            MES_TRACE(order_assigned, qry.tray_id, order_id, qry.workstation_id);
+
+            ST_ProcessInfo process;
+            const bool has_process = process_manager_->GetNextProcessToExecute(order_id, process);
+            if (release_controller_ != nullptr)
+            {
+                ST_OrderProgress progress;
+                if (order_manager_->GetOrderProgress(order_id, progress))
+                    release_controller_->OnOrderReleased(order_id, progress.product_type,
+                        has_process ? process : ReleaseController::no_process, Now());
+            }
+            if (!has_process)
+            {
+                MES_LOG_ERROR("[MES] Failed to find the process to execute at station {}", qry.workstation_id);
+                return rsp;
+            }
+            if (!process_manager_->ProcessCanBeExecutedAtStation(process, qry.workstation_id))
+            {
+                uint32_t next_station = UINT32_MAX;
+                uint32_t target_station = UINT32_MAX;
+                if (!PlanRouteToProcessStation(qry.workstation_id, process, next_station, target_station))
+                {
+                    MES_LOG_ERROR("[MES] Cannot plan route to station for next process, default release.");
+                    rsp.order_id = UINT32_MAX;
+                    return rsp;
+                }
+                rsp.action_type = 0;
+                rsp.next_station_id = next_station;
+                tray_states_->SetRouteTarget(tray_slot, target_station);
+                MES_LOG_INFO("[MES] Routing tray {} to station {}", qry.tray_id, next_station);
+                return rsp;
+            }
+            // TODO assume for now one station only execute one type of process, so merely returning  1 meaning execute
+            rsp.action_type = 1;
+            graph_manager_->AddTimeDistToAllPathsToVertex(qry.workstation_id);
+            MES_TRACE(process_start, qry.tray_id, order_id, qry.workstation_id, process);
+            MES_LOG_INFO("[MES] Execute process {} at station {}", process, qry.workstation_id);
+            return rsp;
+        }
+        MES_LOG_INFO("[MES] Tray not at order assigning station, default release.");
+        return rsp;
+    }
+    // Else order executing on the tray
+    ST_ProcessInfo process;
+    const auto order_id = tray_states_->GetOrderId(tray_slot);
+    if (!process_manager_->GetNextProcessToExecute(order_id, process))
+    {
+        MES_LOG_INFO("[MES] Failed to find the process to execute anymore {}", qry.workstation_id);
+        // Treating any type of false return as finished (actually containing error cases)
+        order_manager_->UpdateOrderStatus(order_id);
+        if (release_controller_ != nullptr)
+            release_controller_->OnOrderFinished(order_id, Now());
+        tray_states_->SetOrderId(tray_slot, UINT32_MAX);
+        MES_TRACE(order_finished, qry.tray_id, order_id, qry.workstation_id);
+        rsp.order_id = UINT32_MAX;
+        MES_LOG_INFO("[MES] Tray {} status reset", qry.tray_id);
+        return rsp;
+    }
+    if (!process_manager_->ProcessCanBeExecutedAtStation(process, qry.workstation_id))
+    {
+        uint32_t next_station = UINT32_MAX;
+        uint32_t target_station = UINT32_MAX;
+        if (!PlanRouteToProcessStation(qry.workstation_id, process, next_station, target_station))
+        {
+            MES_LOG_INFO("[MES] Cannot plan route to station for next process, default release.");
+            return rsp;
+        }
+        rsp.action_type = 0;
+        rsp.next_station_id = next_station;
+        tray_states_->SetRouteTarget(tray_slot, target_station);
+        MES_LOG_INFO("[MES] Routing tray {} to station {}", qry.tray_id, next_station);
+        return rsp;
+    }
+    // TODO assume for now one station only execute one type of process, so merely returning  1 meaning execute
+    rsp.action_type = 1;
+    graph_manager_->AddTimeDistToAllPathsToVertex(qry.workstation_id);
+    MES_TRACE(process_start, qry.tray_id, order_id, qry.workstation_id, process);
+    MES_LOG_INFO("[MES] Execute process {} at station {}", process, qry.workstation_id);
+    return rsp;
+}
+
+ST_StationActionRsp MESCore::OnStationActionDoneQuery(const ST_StationActionQuery& qry, ST_StationRoutePush * out_push)
+{
+    if (out_push != nullptr)
+        out_push->route_length = 0;
+    // Construct default releasing response
+    const auto tray_slot = tray_states_->Find(qry.tray_id);
+    auto rsp = MakeDefaultReleaseRsp(tray_slot, qry);
+
+    if (tray_slot == TrayStateTable::npos || !tray_states_->IsExecutingOrder(tray_slot))
+    {
+        // This case shouldn't exist
+        MES_LOG_ERROR("[MES] Action done for a non-existing order");
+        return rsp;
+    }
+    ST_OrderProgress progress;
+    const auto order_id = tray_states_->GetOrderId(tray_slot);
+    if (!order_manager_->GetOrderProgress(order_id, progress))
+    {
+        // This case shouldn't exist
+        MES_LOG_ERROR("[MES] Action done for a non-existing order");
+        return rsp;
+    }
+    // TODO for now only consider one process possible for one station
+    const auto station_it = process_manager_->station_process_map_.find(qry.workstation_id);
+    if (station_it == process_manager_->station_process_map_.end() || station_it->second.empty())
+    {
+        MES_LOG_ERROR("[MES] Action done at station {} without process capability", qry.workstation_id);
+        return rsp;
+    }
+    const auto done_process = station_it->second.front();
+    ST_ProcessInfo expected_process;
+    const bool follows_routing = process_manager_->GetNextProcessToExecute(order_id, expected_process) &&
+        expected_process == done_process;
+    order_manager_->OnOrderProcessSuccess(order_id, done_process, follows_routing);
+    if (release_controller_ != nullptr)
+    {
+        ST_ProcessInfo next_process;
+        release_controller_->OnOrderProgress(order_id, process_manager_->GetNextProcessToExecute(order_id, next_process)
+            ? next_process : ReleaseController::no_process);
+    }
+    MES_TRACE(process_done, qry.tray_id, order_id, qry.workstation_id, done_process);
+    rsp.order_id = UINT32_MAX;
+    graph_manager_->AddTimeDistToAllPathsToVertex(qry.workstation_id, false);
+    // Hand over to the station action decision
+    return OnTrayAtStation(tray_slot, qry, out_push);
+}
+
+bool MESCore::BuildRoutePush(const uint32_t tray_slot, const ST_StationActionRsp& rsp, ST_StationRoutePush& out) const
+{
+    // Only releases towards a planned process station carry a route, default releases are still decided per hop
+    out.route_length = 0;
+    const auto target = tray_states_->GetRouteTarget(tray_slot);
+    if (target == TrayStateTable::npos || target == rsp.qry.workstation_id)
+        return false;
+
+    std::vector<uint32_t> path;
+    float length;
+    if (!graph_manager_->FindShortestPath(rsp.qry.workstation_id, target, path, length) || path.size() < 2)
+        return false;
+    // The path starts at the current station
+    if (path.size() - 1 > MES_MAX_ROUTE_LENGTH || path[1] != rsp.next_station_id)
+        return false;
+
+    out.tray_id = rsp.qry.tray_id;
+    out.order_id = rsp.order_id;
+    out.route_length = static_cast<uint32_t>(path.size() - 1);
+    std::copy(path.begin() + 1, path.end(), out.stations);
+    return true;
+}
+
+bool MESCore::FindNextStationToTargetStation(const uint32_t& current_station, const uint32_t& target_station,
+                                               uint32_t& out) const
+{
+    // If current_station == target_station, return the same station
+    float length;
+    if (!graph_manager_->FindNextHop(current_station, target_station, out, length))
+    {
+        MES_LOG_ERROR("[Graph] No path from station {} to station {}", current_station, target_station);
+        return false;
+    }
+    return true;
+}
+
+bool MESCore::PlanRouteToProcessStation(uint32_t current_station, const ST_ProcessInfo process,
+    uint32_t & out_next_station, uint32_t & out_target_station) const
+{
+    MES_METRIC_TIME_SCOPE("mes_route_plan_seconds", "Time spent in MESCore::PlanRouteToProcessStation");
+    // Next process cannot execute here, find stations available for next process
+    const auto * next_stations = process_manager_->GetStationsForProcess(process);
+    if (next_stations == nullptr)
+    {
+        MES_LOG_ERROR("[MES] Cannot find stations  available for next process");
+        return false;
+    }
+
+    // Route to the candidate station with the smallest expected transfer plus waiting time, in a single lookup pass
+    float best_cost = 0.0f;
+    if (!graph_manager_->FindLeastCongestedVertex(current_station, *next_stations, out_target_station, out_next_station, best_cost))
+    {
+        MES_LOG_ERROR("[MES] None of the candidate stations is reachable from station {}", current_station);
+        return false; // keep default release decision
+    }
+    return true;
+}
+
+uint32_t MESCore::CalculateDefaultNextStation(const uint32_t& current_station) const
+{
+    // Used for default releasing response when no additional information can be derived.
+    VertexRole role = VertexRole::internal;
+    if (!graph_manager_->GetVertexRole(current_station, role))
+    {
+        MES_LOG_ERROR("[Graph] Cannot determine role for station {}", current_station);
+        return UINT32_MAX;
+    }
+
+    if (role == VertexRole::sink)
+        return UINT32_MAX;
+
+    const auto outgoing_neighbors = graph_manager_->GetOutgoingNeighborVertices(current_station);
+    if (outgoing_neighbors.empty())
+    {
+        MES_LOG_ERROR("[Graph] No outgoing neighbors from station {}", current_station);
+        return UINT32_MAX;
+    }
+    return outgoing_neighbors.front();
+}
+
+void MESCore::UpdateTrayStation(const uint32_t tray_slot, const uint32_t station_id, const TrayRouteState state) const
+{
+    // A released tray counts towards its next station right away, so routing sees trays on their way there
+    const auto previous_station = tray_states_->GetStation(tray_slot);
+    if (previous_station != station_id)
+    {
+        if (previous_station != UINT32_MAX)
+            graph_manager_->OnTrayDeparted(previous_station);
+        if (station_id != UINT32_MAX)
+            graph_manager_->OnTrayArrived(station_id);
+        tray_states_->SetStation(tray_slot, station_id);
+    }
+    // Queries after a process at the same station do not count as a new arrival
+    if (state == TrayRouteState::at_station &&
+        (previous_station != station_id || tray_states_->GetRouteState(tray_slot) == TrayRouteState::in_transit))
+    {
+        tray_states_->SetArrivalTime(tray_slot, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()));
+    }
+    tray_states_->SetRouteState(tray_slot, state);
+}
+
+void MESCore::CreateOrderBatch(const uint32_t num, const uint8_t product_type) const
+{
+    if (!process_manager_->HasProduct(product_type))
+    {
+        MES_LOG_ERROR("[MES] Cannot create order batch: product type {} is not configured", product_type);
+        return;
+    }
+    order_manager_->AddProductionTarget(product_type, num);
+}
+
+void MESCore::CreateStartupOrders(const json& j_product_info) const
+{
+    for (const auto & batch_cfg : j_product_info.value("startup_order_batches", json::array()))
+        CreateOrderBatch(batch_cfg["count"].get<uint32_t>(), batch_cfg["product_type"].get<uint8_t>());
+    for (const auto & order_cfg : j_product_info.value("startup_customer_orders", json::array()))
+    {
+        for (uint32_t i = 0; i < order_cfg.value("count", 1u); ++i)
+            SubmitCustomerOrder(order_cfg["product_type"].get<uint8_t>(), order_cfg.value("priority", uint8_t{0}),
+                order_cfg["due"].get<double>());
+    }
+}
+
+uint32_t MESCore::SubmitCustomerOrder(const uint8_t product_type, const uint8_t priority, const double due_in) const
+{
+    // A NaN due time would break the ordering of the customer order heaps
+    if (!std::isfinite(due_in))
+    {
+        MES_LOG_ERROR("[MES] Cannot submit customer order: due in {} is not finite", due_in);
+        return UINT32_MAX;
+    }
+    if (!process_manager_->HasProduct(product_type))
+    {
+        MES_LOG_ERROR("[MES] Cannot submit customer order: product type {} is not configured", product_type);
+        return UINT32_MAX;
+    }
+    const auto order_id = order_manager_->SubmitCustomerOrder(product_type, priority, Now() + due_in);
+    MES_LOG_INFO("[MES] Customer order {} of product type {} due in {}", order_id, product_type, due_in);
+    return order_id;
+}
+
+bool MESCore::UpdateCustomerOrder(const uint32_t order_id, const uint8_t priority, const double due_in) const
+{
+    if (!std::isfinite(due_in))
+    {
+        MES_LOG_ERROR("[MES] Cannot update customer order {}: due in {} is not finite", order_id, due_in);
+        return false;
+    }
+    if (!order_manager_->UpdateCustomerOrder(order_id, priority, Now() + due_in))
+    {
+        MES_LOG_WARN("[MES] Cannot update customer order {}: not pending", order_id);
+        return false;
+    }
+    MES_LOG_INFO("[MES] Customer order {} now has priority {} and is due in {}", order_id, priority, due_in);
+    return true;
+}
+
+bool MESCore::CancelCustomerOrder(const uint32_t order_id) const
+{
+    if (!order_manager_->CancelCustomerOrder(order_id))
+    {
+        MES_LOG_WARN("[MES] Cannot cancel customer order {}: not pending", order_id);
+        return false;
+    }
+    MES_LOG_INFO("[MES] Customer order {} cancelled", order_id);
+    return true;
+}
+
+void MESCore::SetClock(Clock clock)
+{
+    clock_ = std::move(clock);
+}
+
+double MESCore::Now() const
+{
+    return clock_ ? clock_() : WallClockAt(MESMetrics::NowNs());
+}
+
+double MESCore::WallClockAt(const uint64_t time_ns) const
+{
+    return static_cast<double>(time_ns - start_ns_) * 1e-9 * graph_time_per_second_;
+}
+
+bool MESCore::QuoteOrderCompletion(const uint32_t order_id, ST_CompletionQuote& out)
+{
+    ST_CompletionQuery query;
+    if (!BuildCompletionQuery(order_id, query))
+        return false;
+    return completion_estimator_->Quote(query, out);
+}
+
+void MESCore::QuoteOrdersCompletion(const std::vector<uint32_t>& order_ids, std::vector<ST_CompletionQuote>& out)
+{
+    std::vector<ST_CompletionQuery> queries(order_ids.size());
+    std::vector<uint8_t> built(order_ids.size(), 0);
+    for (size_t i = 0; i < order_ids.size(); ++i)
+        built[i] = BuildCompletionQuery(order_ids[i], queries[i]) ? 1 : 0;
+
+    out.assign(order_ids.size(), ST_CompletionQuote{});
+    completion_estimator_->QuoteBatch(queries, out);
+    for (size_t i = 0; i < order_ids.size(); ++i)
+        if (!built[i])
+            out[i] = ST_CompletionQuote{};
+}
+
+bool MESCore::BuildCompletionQuery(const uint32_t order_id, ST_CompletionQuery& out) const
+{
+    ST_OrderProgress progress;
+    if (!order_manager_->GetOrderProgress(order_id, progress) || progress.status == ORDER_FINISHED)
+        return false;
+
+    const auto * product = process_manager_->GetProduct(progress.product_type);
+    if (product == nullptr || !product->GetRemainingProcesses(progress, out.remaining_processes))
+        return false;
+
+    // Orders not on a tray yet start from the order assigning station
+    out.current_station = process_manager_->GetDefaultReturningStation();
+    if (const auto tray_slot = tray_states_->Find(progress.tray_id); tray_slot != TrayStateTable::npos)
+    {
+        if (const auto station = tray_states_->GetStation(tray_slot); station != UINT32_MAX)
+            out.current_station = station;
+    }
+    return true;
+}
@@ -0,0 +1,130 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_MESCORE_H
+#define RECONFIGMANUS_MESCORE_H
+
+#include "mes_server_def.h"
+#include "GraphManager.h"
+#include "OrderManager.h"
+#include "ProcessManager.h"
+#include "CompletionTimeEstimator.h"
+#include "TrayStateTable.h"
+#include "ReleaseController.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Optional MES decision behaviour, read from the `mes_service` section of the server config
+struct ST_MESCoreOptions
+{
+    uint32_t eta_threads = 0;           // completion time sampling threads, 0 for hardware concurrency
+    uint32_t eta_samples = 1000;        // Monte Carlo samples per quote
+    uint64_t eta_seed = 1;
+    uint32_t max_trays = 1024;          // capacity of the tray state table, a hard limit: trays beyond it never get orders
+    bool route_push = false;            // push the full route to the next process station on release
+    uint32_t trace_events = 0;          // capacity of the process-wide event trace ring, 0 to disable tracing
+    uint64_t order_seed = 0;            // order assignment seed, 0 to draw a random one
+    OrderReleasePolicy order_release_policy = OrderReleasePolicy::weighted_random;  // product type of the next order
+    DispatchRule dispatch_rule = DispatchRule::edd;     // order of the customer orders
+    double graph_time_per_second = 1.0;                 // graph time units per wall second of the MES clock
+    bool release_control = false;       // CONWIP release, WIP caps per product from the graph capacities
+    bool release_adaptive = false;      // tune the WIP caps on throughput / lead time
+};
+
+// Reads the decision options of the `mes_service` config section, missing fields keep their defaults.
+// Shared by MESServer and MESReplay so a journal is replayed with the options it was recorded with.
+// Throws on malformed values.
+void ParseMESCoreOptions(const json & j_service, ST_MESCoreOptions & out);
+
+// MES decision core: system graph, processes, orders, trays and the control policies, without any
+// transport. MESServer wraps it for TCP clients, simulations can also link it and call it in-process.
+// Queries of one tray must be answered in order, queries of different trays may run concurrently.
+class MESCore
+{
+public:
+    MESCore(const json & j_graph, const json & j_capabilities, const json & j_products,
+        const ST_MESCoreOptions & options = {});
+
+    ~MESCore() = default;
+
+    // Answer a MSG_STATION_ACTION_QUERY or MSG_STATION_ACTION_DONE_QUERY.
+    // With route push enabled and out_push given, out_push receives the route to send after the response
+    // (route_length 0 if there is none).
+    ST_StationActionRsp AnswerStationQuery(uint32_t msg_type, const ST_StationActionQuery& qry,
+        ST_StationRoutePush * out_push = nullptr);
+    // Answer a batch in item order on the calling thread, out holds one response per item, out_pushes
+    // one route per item if not empty
+    void AnswerStationQueries(std::span<const ST_StationActionBatchItem> items, std::span<ST_StationActionRsp> out,
+        std::span<ST_StationRoutePush> out_pushes = {});
+
+    // Control policies
+    ST_StationActionRsp OnStationActionQuery(const ST_StationActionQuery& qry, ST_StationRoutePush * out_push = nullptr);
+    ST_StationActionRsp OnStationActionDoneQuery(const ST_StationActionQuery& qry, ST_StationRoutePush * out_push = nullptr);
+    bool FindNextStationToTargetStation(const uint32_t & current_station, const uint32_t & target_station, uint32_t & out) const;
+    bool PlanRouteToProcessStation(uint32_t current_station, ST_ProcessInfo process,
+        uint32_t & out_next_station, uint32_t & out_target_station) const;
+    [[nodiscard]] uint32_t CalculateDefaultNextStation(const uint32_t & current_station) const;
+
+    void CreateOrderBatch(uint32_t num, uint8_t product_type) const;
+    // startup_order_batches and startup_customer_orders of the `product_info` config section
+    void CreateStartupOrders(const json & j_product_info) const;
+    // Customer order due in due_in graph time units from now, UINT32_MAX if the product is not configured
+    // or due_in is not finite
+    uint32_t SubmitCustomerOrder(uint8_t product_type, uint8_t priority, double due_in) const;
+    // Only orders not released yet, false otherwise or if due_in is not finite
+    bool UpdateCustomerOrder(uint32_t order_id, uint8_t priority, double due_in) const;
+    bool CancelCustomerOrder(uint32_t order_id) const;
+    // MES clock in graph time units. The default one is the wall clock, scaled by graph_time_per_second,
+    // since the core was created. A replay or a server that times decisions by message arrival drives
+    // it instead; set it before any query, it is called from the query threads.
+    using Clock = std::function<double()>;
+    void SetClock(Clock clock);
+    [[nodiscard]] double Now() const;
+    // Default clock reading at a MESMetrics::NowNs() timestamp
+    [[nodiscard]] double WallClockAt(uint64_t time_ns) const;
+
+    // Completion time quotes (P50/P95/P99) for the remaining processes of orders
+    bool QuoteOrderCompletion(uint32_t order_id, ST_CompletionQuote & out);
+    void QuoteOrdersCompletion(const std::vector<uint32_t> & order_ids, std::vector<ST_CompletionQuote> & out);
+
+    [[nodiscard]] bool IsRoutePushEnabled() const { return route_push_; }
+
+    [[nodiscard]] GraphManager & GetGraphManager() const { return *graph_manager_; }
+    [[nodiscard]] ProcessManager & GetProcessManager() const { return *process_manager_; }
+    [[nodiscard]] OrderManager & GetOrderManager() const { return *order_manager_; }
+    [[nodiscard]] const TrayStateTable & GetTrayStates() const { return *tray_states_; }
+    // nullptr unless release control is enabled
+    [[nodiscard]] const ReleaseController * GetReleaseController() const { return release_controller_.get(); }
+    // Seed in use, the drawn one if none was given
+    [[nodiscard]] uint64_t GetOrderSeed() const { return order_seed_; }
+
+protected:
+    ST_StationActionRsp OnTrayAtStation(uint32_t tray_slot, const ST_StationActionQuery& qry, ST_StationRoutePush * out_push);
+    bool BuildRoutePush(uint32_t tray_slot, const ST_StationActionRsp& rsp, ST_StationRoutePush& out) const;
+    ST_StationActionRsp DecideStationAction(uint32_t tray_slot, const ST_StationActionQuery& qry);
+    ST_StationActionRsp MakeDefaultReleaseRsp(uint32_t tray_slot, const ST_StationActionQuery& qry) const;
+    static void RecordDecision(const ST_StationActionRsp& rsp, uint32_t previous_target, uint32_t route_target);
+    void UpdateTrayStation(uint32_t tray_slot, uint32_t station_id, TrayRouteState state) const;
+    bool BuildCompletionQuery(uint32_t order_id, ST_CompletionQuery & out) const;
+    void SetupReleaseControl(bool adaptive, const std::vector<std::pair<uint8_t, double>> & route_times);
+
+    std::unique_ptr<GraphManager> graph_manager_;
+    std::unique_ptr<OrderManager> order_manager_;
+    std::unique_ptr<ProcessManager> process_manager_;
+    std::unique_ptr<CompletionTimeEstimator> completion_estimator_;
+    std::unique_ptr<TrayStateTable> tray_states_;
+    std::unique_ptr<ReleaseController> release_controller_;
+
+    std::atomic<bool> tray_table_full_reported_{false};
+    bool route_push_ = false;
+    uint64_t order_seed_ = 0;
+    Clock clock_;
+    uint64_t start_ns_ = 0;
+    double graph_time_per_second_ = 1.0;
+};
+
+#endif //RECONFIGMANUS_MESCORE_H
@@ -3,17 +3,101 @@
 //
 
 #include "MESServer.h"
-#include "LogMacros.h"
+#include "AsyncLogger.h"
+#include "Metrics.h"
+#include "Tracer.h"
 #include "mes_server_def.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
 #include <memory>
 
-MESServer::MESServer(uint16_t port, const json& j_graph, const json& j_capabilities, const json& j_products)
+namespace {
+
+struct ST_MessageMetrics
+{
+    MESMetrics::Counter & received;
+    MESMetrics::LatencyHistogram & latency;
+};
+
+ST_MessageMetrics MakeMessageMetrics(const char * type)
+{
+    auto & registry = MESMetrics::Registry::Instance();
+    const std::string labels = std::string("type=\"") + type + "\"";
+    return {registry.GetCounter("mes_messages_total", "Messages received by type", labels),
+        registry.GetHistogram("mes_message_latency_seconds", "Time from message arrival to reply by type", labels)};
+}
+
+const ST_MessageMetrics & MessageMetrics(const uint32_t msg_type)
+{
+    static const ST_MessageMetrics station_action = MakeMessageMetrics("station_action_query");
+    static const ST_MessageMetrics station_action_done = MakeMessageMetrics("station_action_done_query");
+    static const ST_MessageMetrics station_action_batch = MakeMessageMetrics("station_action_batch_query");
+    static const ST_MessageMetrics order_eta = MakeMessageMetrics("order_eta_query");
+    static const ST_MessageMetrics stats = MakeMessageMetrics("stats_query");
+    static const ST_MessageMetrics trace_dump = MakeMessageMetrics("trace_dump_query");
+    static const ST_MessageMetrics customer_order = MakeMessageMetrics("customer_order_submit");
+    static const ST_MessageMetrics customer_order_update = MakeMessageMetrics("customer_order_update");
+    static const ST_MessageMetrics customer_order_cancel = MakeMessageMetrics("customer_order_cancel");
+    static const ST_MessageMetrics unknown = MakeMessageMetrics("unknown");
+    switch (msg_type)
+    {
+        case MSG_STATION_ACTION_QUERY: return station_action;
+        case MSG_STATION_ACTION_DONE_QUERY: return station_action_done;
+        case MSG_STATION_ACTION_BATCH_QUERY: return station_action_batch;
+        case MSG_ORDER_ETA_QUERY: return order_eta;
+        case MSG_MES_STATS_QUERY: return stats;
+        case MSG_MES_TRACE_DUMP_QUERY: return trace_dump;
+        case MSG_CUSTOMER_ORDER_SUBMIT: return customer_order;
+        case MSG_CUSTOMER_ORDER_UPDATE: return customer_order_update;
+        case MSG_CUSTOMER_ORDER_CANCEL: return customer_order_cancel;
+        default: return unknown;
+    }
+}
+
+void RecordReplyLatency(const uint32_t msg_type, const uint64_t received_ns)
+{
+    MessageMetrics(msg_type).latency.Record(MESMetrics::NowNs() - received_ns);
+}
+
+// MES clock of the message handled on this thread
+thread_local double t_message_time = 0.0;
+
+}
+
+MESServer::MESServer(uint16_t port, const json& j_graph, const json& j_capabilities, const json& j_products,
+    const ST_MESServerOptions& options)
     : ITCPServer<TCPConn::TCPMsg>(port)
 {
-    graph_manager_ = std::make_unique<GraphManager>(j_graph);
-    graph_manager_->WriteOutDotFile("system_graph.dot");
-    process_manager_ = std::make_unique<ProcessManager>(std::shared_ptr<MESServer>(this), j_capabilities, j_products);
-    order_manager_ = std::make_unique<OrderManager>();
+    core_ = std::make_unique<MESCore>(j_graph, j_capabilities, j_products, options);
+    core_->GetGraphManager().WriteOutDotFile("system_graph.dot");
+    core_->SetClock([] { return t_message_time; });
+    trace_file_ = options.trace_file;
+    trace_writer_ = std::make_unique<ThreadPool>(1);
+    if (!options.journal_file.empty() && options.dispatch_threads > 0)
+    {
+        // Shard threads append after replying, the journal order would not be the order decisions were taken in
+        MES_LOG_ERROR("[MES] Journal {} disabled, journaling needs dispatch_threads 0", options.journal_file);
+    }
+    else if (!options.journal_file.empty())
+    {
+        journal_ = std::make_unique<QueryJournalWriter>();
+        if (journal_->Open(options.journal_file, core_->GetOrderSeed()))
+            MES_LOG_INFO("[MES] Journaling station queries to {}", options.journal_file);
+        else
+        {
+            MES_LOG_ERROR("[MES] Cannot open journal {}", options.journal_file);
+            journal_.reset();
+        }
+    }
+    if (options.dispatch_threads > 0)
+        dispatcher_ = std::make_unique<ShardedExecutor>(options.dispatch_threads);
+}
+
+MESServer::~MESServer()
+{
+    // Let the workers finish the queued queries while the core is still alive
+    dispatcher_.reset();
 }
 
 bool MESServer::OnClientConnectionRequest(std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>> client)
@@ -34,266 +118,323 @@ void MESServer::OnClientDisconnected(std::shared_ptr<TCPConn::ITCPConn<TCPConn::
 
 void MESServer::OnMessage(std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>> client, TCPConn::TCPMsg& msg)
 {
+    const auto received_ns = MESMetrics::NowNs();
+    MessageMetrics(msg.header.type).received.Inc();
     switch (msg.header.type)
     {
         // TODO
         case MSG_STATION_ACTION_QUERY:
+        case MSG_STATION_ACTION_DONE_QUERY:
             {
                 ST_StationActionQuery qry;
                 msg >> qry;
-                INFO_MSG("[MES] Action query received: workstation_id: {}, tray_id: {}", qry.workstation_id, qry.tray_id);
-                const auto rsp = OnStationActionQuery(qry);
-                TCPConn::TCPMsg rsp_msg;
-                rsp_msg.header.type = MSG_STATION_ACTION_RSP;
-                rsp_msg << rsp;
-                client->Send(rsp_msg);
+                const auto type = msg.header.type;
+                // Queries of one tray always land on the same worker, so they are handled in arrival order
+                if (dispatcher_)
+                    dispatcher_->Post(qry.tray_id, [this, client, type, qry, received_ns] {
+                        HandleStationQuery(client, type, qry, received_ns);
+                    });
+                else
+                    HandleStationQuery(client, type, qry, received_ns);
             }
             break;
-        case MSG_STATION_ACTION_DONE_QUERY:
+        case MSG_STATION_ACTION_BATCH_QUERY:
             {
-                ST_StationActionQuery qry;
-                msg >> qry;
-                INFO_MSG("[MES] Action done query received: workstation_id: {}, tray_id: {}", qry.workstation_id, qry.tray_id);
-                const auto rsp = OnStationActionDoneQuery(qry);
-                TCPConn::TCPMsg rsp_msg;
-                rsp_msg.header.type = MSG_STATION_ACTION_RSP;
-                rsp_msg << rsp;
-                client->Send(rsp_msg);
+                // The count is read from the end of the body, it must hold it and exactly count items
+                if (msg.body.size() < sizeof(uint32_t))
+                {
+                    MES_LOG_ERROR("[MES] Batch query of {} bytes without an item count, dropped", msg.body.size());
+                    break;
+                }
+                uint32_t count = 0;
+                msg >> count;
+                if (count > MES_MAX_BATCH_ITEMS)
+                {
+                    MES_LOG_ERROR("[MES] Batch query of {} items exceeds the limit of {}", count, MES_MAX_BATCH_ITEMS);
+                    break;
+                }
+                if (msg.body.size() != count * sizeof(ST_StationActionBatchItem))
+                {
+                    MES_LOG_ERROR("[MES] Batch query of {} items with {} item bytes, dropped", count, msg.body.size());
+                    break;
+                }
+                // Items were written first to last, so they are read back last to first
+                std::vector<ST_StationActionBatchItem> items(count);
+                for (auto it = items.rbegin(); it != items.rend(); ++it)
+                    msg >> *it;
+                HandleStationBatchQuery(client, std::move(items), received_ns);
             }
             break;
-        default:
-            break;
-    }
-
-}
-
-ST_StationActionRsp MESServer::OnStationActionQuery(const ST_StationActionQuery& qry)
-{
-    // Construct default releasing response
-    ST_StationActionRsp rsp;
-    auto & tray_info = GetTrayInfo(qry.tray_id);
-    rsp.qry = qry;
-    // Set order_id based on whether the tray has an executing order
-    rsp.order_id = tray_info.executing_order ? tray_info.current_order_id : UINT32_MAX;
-    rsp.action_type = 0;    // Default action: release
-    rsp.next_station_id = CalculateDefaultNextStation(qry.workstation_id);
-
-    if (!tray_info.executing_order)
-    {
-        // Try assigning order to the tray only if at order assigning station
-        if (process_manager_->IsOrderAssigningStation(qry.workstation_id))
-        {
-            // if no order waiting, release
-            if (order_manager_->GetWaitOrderNum() == 0)
+        case MSG_ORDER_ETA_QUERY:
             {
-                INFO_MSG("[MES] No order waiting, default release.");
-                return rsp;
+                ST_OrderEtaQuery qry;
+                msg >> qry;
+                if (dispatcher_)
+                    dispatcher_->Post(qry.order_id, [this, client, qry, received_ns] { HandleOrderEtaQuery(client, qry, received_ns); });
+                else
+                    HandleOrderEtaQuery(client, qry, received_ns);
             }
-            // Else there are orders waiting, try assign
-            uint32_t order_id;
-            if (!order_manager_->TryAssignNewOrderToTray(qry.tray_id, order_id))
+            break;
+        case MSG_MES_STATS_QUERY:
+            HandleStatsQuery(client);
+            RecordReplyLatency(MSG_MES_STATS_QUERY, received_ns);
+            break;
+        case MSG_MES_TRACE_DUMP_QUERY:
+            HandleTraceDumpQuery(client, received_ns);
+            break;
+        case MSG_CUSTOMER_ORDER_SUBMIT:
             {
-                // Assigning failed, release
-                INFO_MSG("[MES] Assigning order failed, default release.");
-                return rsp;
+                ST_CustomerOrderSubmit submit;
+                msg >> submit;
+                HandleCustomerOrderSubmit(client, submit, received_ns);
+                RecordReplyLatency(MSG_CUSTOMER_ORDER_SUBMIT, received_ns);
             }
-            // Else assigning success
-            tray_info.executing_order = true;
-            tray_info.current_order_id = order_id;
-            rsp.order_id = order_id;
-
-            ST_ProcessInfo process;
-            if (!process_manager_->GetNextProcessToExecute(order_id, process))
+            break;
+        case MSG_CUSTOMER_ORDER_UPDATE:
             {
-                ERROR_MSG("[MES] Failed to find the process to execute at station {}", qry.workstation_id);
-                return rsp;
+                ST_CustomerOrderUpdate update;
+                msg >> update;
+                HandleCustomerOrderUpdate(client, update, received_ns);
+                RecordReplyLatency(MSG_CUSTOMER_ORDER_UPDATE, received_ns);
             }
-            if (!process_manager_->ProcessCanBeExecutedAtStation(process, qry.workstation_id))
+            break;
+        case MSG_CUSTOMER_ORDER_CANCEL:
             {
-                uint32_t next_station = UINT32_MAX;
-                if (!PlanRouteToProcessStation(qry.workstation_id, process, next_station))
-                {
-                    ERROR_MSG("[MES] Cannot plan route to station for next process, default release.");
-                    rsp.order_id = UINT32_MAX;
-                    return rsp;
-                }
-                rsp.action_type = 0;
-                rsp.next_station_id = next_station;
-                INFO_MSG("[MES] Routing tray {} to station {}", qry.tray_id, next_station);
-                return rsp;
+                ST_CustomerOrderCancel cancel;
+                msg >> cancel;
+                HandleCustomerOrderCancel(client, cancel, received_ns);
+                RecordReplyLatency(MSG_CUSTOMER_ORDER_CANCEL, received_ns);
             }
-            // TODO assume for now one station only execute one type of process, so merely returning  1 meaning execute
-            rsp.action_type = 1;
-            graph_manager_->AddTimeDistToAllPathsToVertex(qry.workstation_id);
-            INFO_MSG("[MES] Execute process {} at station {}", process, qry.workstation_id);
-            return rsp;
-        }
-        INFO_MSG("[MES] Tray not at order assigning station, default release.");
-        return rsp;
-    }
-    // Else order executing on the tray
-    ST_ProcessInfo process;
-    if (!process_manager_->GetNextProcessToExecute(tray_info.current_order_id, process))
-    {
-        INFO_MSG("[MES] Failed to find the process to execute anymore {}", qry.workstation_id);
-        // Treating any type of false return as finished (actually containing error cases)
-        order_manager_->UpdateOrderStatus(tray_info.current_order_id);
-        tray_info.executing_order = false;
-        tray_info.current_order_id = UINT32_MAX;
-        rsp.order_id = UINT32_MAX;
-        INFO_MSG("[MES] Tray {} status reset", qry.tray_id);
-        return rsp;
+            break;
+        default:
+            break;
     }
-    if (!process_manager_->ProcessCanBeExecutedAtStation(process, qry.workstation_id))
+
+}
+
+void MESServer::HandleStationQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+    const uint32_t msg_type, const ST_StationActionQuery& qry, const uint64_t received_ns)
+{
+    const auto now = SetMessageTime(received_ns);
+    if (!core_->IsRoutePushEnabled())
     {
-        uint32_t next_station = UINT32_MAX;
-        if (!PlanRouteToProcessStation(qry.workstation_id, process, next_station))
-        {
-            INFO_MSG("[MES] Cannot plan route to station for next process, default release.");
-            return rsp;
-        }
-        rsp.action_type = 0;
-        rsp.next_station_id = next_station;
-        INFO_MSG("[MES] Routing tray {} to station {}", qry.tray_id, next_station);
-        return rsp;
+        const auto rsp = core_->AnswerStationQuery(msg_type, qry);
+        TCPConn::TCPMsg rsp_msg;
+        rsp_msg.header.type = MSG_STATION_ACTION_RSP;
+        rsp_msg << rsp;
+        client->Send(rsp_msg);
+        JournalDecision(received_ns, now, msg_type, client->GetID(), qry, rsp);
+        RecordReplyLatency(msg_type, received_ns);
+        return;
     }
-    // TODO assume for now one station only execute one type of process, so merely returning  1 meaning execute
-    rsp.action_type = 1;
-    graph_manager_->AddTimeDistToAllPathsToVertex(qry.workstation_id);
-    INFO_MSG("[MES] Execute process {} at station {}", process, qry.workstation_id);
-    return rsp;
+
+    ST_StationRoutePush push;
+    const auto rsp = core_->AnswerStationQuery(msg_type, qry, &push);
+    TCPConn::TCPMsg rsp_msg;
+    rsp_msg.header.type = MSG_STATION_ACTION_RSP;
+    rsp_msg << rsp;
+    client->Send(rsp_msg);
+    SendRoutePush(client, push);
+    JournalDecision(received_ns, now, msg_type, client->GetID(), qry, rsp);
+    RecordReplyLatency(msg_type, received_ns);
 }
 
-ST_StationActionRsp MESServer::OnStationActionDoneQuery(const ST_StationActionQuery& qry)
+double MESServer::SetMessageTime(const uint64_t received_ns) const
 {
-    // Construct default releasing response
-    ST_StationActionRsp rsp;
-    auto & tray_info = GetTrayInfo(qry.tray_id);
-    rsp.qry = qry;
-    // Set order_id based on whether the tray has an executing order
-    rsp.order_id = tray_info.executing_order ? tray_info.current_order_id : UINT32_MAX;
-    rsp.action_type = 0;    // Default action: release
-    rsp.next_station_id = CalculateDefaultNextStation(qry.workstation_id);
+    t_message_time = core_->WallClockAt(received_ns);
+    return t_message_time;
+}
 
-    if (!tray_info.executing_order)
-    {
-        // This case shouldn't exist
-        ERROR_MSG("[MES] Action done for a non-existing order");
-        return rsp;
-    }
-    Order order;
-    if (!order_manager_->GetOrderByID(tray_info.current_order_id, order))
-    {
-        // This case shouldn't exist
-        ERROR_MSG("[MES] Action done for a non-existing order");
-        return rsp;
-    }
-    // TODO for now only consider one process possible for one station
-    order_manager_->OnOrderProcessSuccess(tray_info.current_order_id, process_manager_->station_process_map_[qry.workstation_id].front());
-    rsp.order_id = UINT32_MAX;
-    graph_manager_->AddTimeDistToAllPathsToVertex(qry.workstation_id, false);
-    // Hand over to OnStationActionQuery
-    return OnStationActionQuery(qry);
+void MESServer::JournalDecision(const uint64_t received_ns, const double now, const uint32_t msg_type,
+    const uint32_t client_id, const ST_StationActionQuery& qry, const ST_StationActionRsp& rsp) const
+{
+    if (journal_)
+        journal_->Append({received_ns, msg_type, client_id, now, qry, rsp, {}});
 }
 
-bool MESServer::FindNextStationToTargetStation(const uint32_t& current_station, const uint32_t& target_station,
-                                               uint32_t& out) const
+void MESServer::JournalCustomerOrder(const uint64_t received_ns, const double now, const uint32_t msg_type,
+    const uint32_t client_id, const ST_JournalCustomerOrder& order) const
 {
-    // TODO maybe can be refactored to `GraphManager`c
-    // If current_station == target_station, return the same station
-    std::vector<uint32_t> path;
-    float length;
-    if (!graph_manager_->FindShortestPath(current_station, target_station, path, length))
-    {
-        ERROR_MSG("[Graph] No path from station {} to station {}", current_station, target_station);
-        return false;
-    }
-    if (path.size() >= 2)
-        out = path[1];
-    else
-        out = path.front();
-    return true;
+    if (journal_)
+        journal_->Append({received_ns, msg_type, client_id, now, {}, {}, order});
 }
 
-bool MESServer::PlanRouteToProcessStation(uint32_t current_station, const ST_ProcessInfo process, uint32_t & out_next_station) const
+void MESServer::SendRoutePush(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+    const ST_StationRoutePush& push)
 {
-    // Next process cannot execute here, find stations available for next process
-    std::list<uint32_t> next_stations;
-    if (!process_manager_->FindStationsForProcess(process, next_stations))
+    if (push.route_length == 0)
+        return;
+    TCPConn::TCPMsg push_msg;
+    push_msg.header.type = MSG_STATION_ROUTE_PUSH;
+    push_msg << push;
+    client->Send(push_msg);
+}
+
+void MESServer::HandleStationBatchQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+    std::vector<ST_StationActionBatchItem> items, const uint64_t received_ns)
+{
+    struct BatchContext
     {
-        ERROR_MSG("[MES] Cannot find stations  available for next process");
-        return false;
-    }
+        std::vector<ST_StationActionBatchItem> items;
+        std::vector<ST_StationActionRsp> rsps;
+        std::vector<ST_StationRoutePush> pushes;    // empty unless route push is enabled
+        std::atomic<size_t> pending_shards{0};
+    };
+    auto ctx = std::make_shared<BatchContext>();
+    ctx->items = std::move(items);
+    ctx->rsps.resize(ctx->items.size());
+    if (core_->IsRoutePushEnabled())
+        ctx->pushes.resize(ctx->items.size());
+
+    // Routes follow the batch response as individual pushes
+    const auto now = core_->WallClockAt(received_ns);
+    const auto send_batch = [this, client, received_ns, now](const BatchContext & batch) {
+        TCPConn::TCPMsg rsp_msg;
+        rsp_msg.header.type = MSG_STATION_ACTION_BATCH_RSP;
+        for (const auto & rsp : batch.rsps)
+            rsp_msg << rsp;
+        rsp_msg << static_cast<uint32_t>(batch.rsps.size());
+        client->Send(rsp_msg);
+        for (const auto & push : batch.pushes)
+            SendRoutePush(client, push);
+        for (size_t i = 0; journal_ && i < batch.items.size(); ++i)
+            JournalDecision(received_ns, now, batch.items[i].query_type, client->GetID(), batch.items[i].qry, batch.rsps[i]);
+        RecordReplyLatency(MSG_STATION_ACTION_BATCH_QUERY, received_ns);
+    };
 
-    // For every possible station, route to the one with the smallest path length
-    float best_len = std::numeric_limits<float>::infinity();
-    uint32_t best_target = UINT32_MAX;
-    for (const auto station_id : next_stations)
+    if (!dispatcher_)
     {
-        std::vector<uint32_t> path;
-        float len = 0.0f;
-        if (!graph_manager_->FindShortestPath(current_station, station_id, path, len))
-            continue; // unreachable, skip
-        if (len < best_len)
-        {
-            best_len = len;
-            best_target = station_id;
-        }
+        SetMessageTime(received_ns);
+        core_->AnswerStationQueries(ctx->items, ctx->rsps, ctx->pushes);
+        send_batch(*ctx);
+        return;
     }
-    if (best_target == UINT32_MAX)
+
+    // Split the batch by dispatch shard so every tray keeps its order, the last shard to finish replies
+    std::vector<std::vector<size_t>> shard_items(dispatcher_->NumShards());
+    for (size_t i = 0; i < ctx->items.size(); ++i)
+        shard_items[ctx->items[i].qry.tray_id % shard_items.size()].push_back(i);
+    const auto used_shards = std::ranges::count_if(shard_items, [](const auto & v) { return !v.empty(); });
+    if (used_shards == 0)
     {
-        ERROR_MSG("[MES] None of the candidate stations is reachable from station {}", current_station);
-        return false; // keep default release decision
+        send_batch(*ctx);
+        return;
     }
-    uint32_t next_station;
-    if (!FindNextStationToTargetStation(current_station, best_target, next_station))
+    ctx->pending_shards = static_cast<size_t>(used_shards);
+    for (size_t shard = 0; shard < shard_items.size(); ++shard)
     {
-        ERROR_MSG("[MES] Failed to compute next station from {} to {}", current_station, best_target);
-        return false;
+        if (shard_items[shard].empty())
+            continue;
+        dispatcher_->Post(static_cast<uint32_t>(shard), [this, ctx, send_batch, received_ns, indices = std::move(shard_items[shard])] {
+            SetMessageTime(received_ns);
+            for (const auto i : indices)
+                ctx->rsps[i] = core_->AnswerStationQuery(ctx->items[i].query_type, ctx->items[i].qry,
+                    ctx->pushes.empty() ? nullptr : &ctx->pushes[i]);
+            if (ctx->pending_shards.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                send_batch(*ctx);
+        });
     }
-    out_next_station = next_station;
-    return true;
 }
 
-uint32_t MESServer::CalculateDefaultNextStation(const uint32_t& current_station) const
+void MESServer::HandleOrderEtaQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+    const ST_OrderEtaQuery& qry, const uint64_t received_ns)
 {
-    // Used for default releasing response when no additional information can be derived.
-    VertexRole role = VertexRole::internal;
-    if (!graph_manager_->GetVertexRole(current_station, role))
+    ST_CompletionQuote quote;
+    ST_OrderEtaRsp rsp{qry.order_id, 0, 0.0f, 0.0f, 0.0f, 0.0f};
+    if (core_->QuoteOrderCompletion(qry.order_id, quote))
     {
-        ERROR_MSG("[Graph] Cannot determine role for station {}", current_station);
-        return UINT32_MAX;
+        rsp.valid = 1;
+        rsp.mean = static_cast<float>(quote.mean);
+        rsp.p50 = static_cast<float>(quote.p50);
+        rsp.p95 = static_cast<float>(quote.p95);
+        rsp.p99 = static_cast<float>(quote.p99);
     }
+    TCPConn::TCPMsg rsp_msg;
+    rsp_msg.header.type = MSG_ORDER_ETA_RSP;
+    rsp_msg << rsp;
+    client->Send(rsp_msg);
+    RecordReplyLatency(MSG_ORDER_ETA_QUERY, received_ns);
+}
 
-    if (role == VertexRole::sink)
-        return UINT32_MAX;
+void MESServer::HandleStatsQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client)
+{
+    const auto text = MESMetrics::Registry::Instance().RenderPrometheus();
+    TCPConn::TCPMsg rsp_msg;
+    rsp_msg.header.type = MSG_MES_STATS_RSP;
+    for (const char c : text)
+        rsp_msg << c;
+    rsp_msg << static_cast<uint32_t>(text.size());
+    client->Send(rsp_msg);
+}
+
+void MESServer::HandleTraceDumpQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+    const uint64_t received_ns)
+{
+    auto events = std::make_shared<std::vector<MESTrace::ST_TraceEvent>>();
+    MESTrace::Tracer::Instance().Snapshot(*events);
+    trace_writer_->Submit([this, client, events, received_ns] {
+        ST_TraceDumpRsp rsp{0, 0};
+        std::ofstream f(trace_file_);
+        if (f.is_open())
+        {
+            rsp.event_count = static_cast<uint32_t>(MESTrace::Tracer::WriteChromeTrace(f, std::move(*events)));
+            rsp.written = f.good() ? 1 : 0;
+        }
+        if (rsp.written)
+            MES_LOG_INFO("[MES] Trace of {} events written to {}", rsp.event_count, trace_file_.c_str());
+        else
+            MES_LOG_ERROR("[MES] Cannot write the trace to {}", trace_file_.c_str());
+        TCPConn::TCPMsg rsp_msg;
+        rsp_msg.header.type = MSG_MES_TRACE_DUMP_RSP;
+        rsp_msg << rsp;
+        client->Send(rsp_msg);
+        RecordReplyLatency(MSG_MES_TRACE_DUMP_QUERY, received_ns);
+    });
+}
 
-    std::list<uint32_t> outgoing_neighbors;
-    if (!graph_manager_->GetOutgoingNeighborVertices(current_station, outgoing_neighbors))
+void MESServer::HandleCustomerOrderSubmit(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+    const ST_CustomerOrderSubmit& submit, const uint64_t received_ns) const
+{
+    ST_CustomerOrderSubmitRsp rsp{UINT32_MAX};
+    if (submit.product_type <= UINT8_MAX)
     {
-        ERROR_MSG("[Graph] No outgoing neighbors from station {}", current_station);
-        return UINT32_MAX;
+        const auto now = SetMessageTime(received_ns);
+        const auto priority = std::min<uint32_t>(submit.priority, UINT8_MAX);
+        rsp.order_id = core_->SubmitCustomerOrder(static_cast<uint8_t>(submit.product_type),
+            static_cast<uint8_t>(priority), submit.due_in);
+        JournalCustomerOrder(received_ns, now, MSG_CUSTOMER_ORDER_SUBMIT, client->GetID(),
+            {rsp.order_id, submit.product_type, priority, submit.due_in, rsp.order_id != UINT32_MAX ? 1u : 0u});
     }
-    return outgoing_neighbors.front();
+    TCPConn::TCPMsg rsp_msg;
+    rsp_msg.header.type = MSG_CUSTOMER_ORDER_SUBMIT_RSP;
+    rsp_msg << rsp;
+    client->Send(rsp_msg);
 }
 
-ST_TrayInfo& MESServer::GetTrayInfo(uint32_t tray_id)
+void MESServer::HandleCustomerOrderUpdate(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+    const ST_CustomerOrderUpdate& update, const uint64_t received_ns) const
 {
-    // Return existing if present; otherwise create with defaults and return
-    auto it = tray_info_dict_.find(tray_id);
-    if (it != tray_info_dict_.end())
-        return it->second;
-
-    auto [ins_it, inserted] = tray_info_dict_.try_emplace(tray_id, ST_TrayInfo{ tray_id, false, UINT32_MAX});
-    return ins_it->second;
+    const auto now = SetMessageTime(received_ns);
+    const auto priority = std::min<uint32_t>(update.priority, UINT8_MAX);
+    ST_CustomerOrderUpdateRsp rsp{update.order_id, 0};
+    rsp.updated = core_->UpdateCustomerOrder(update.order_id, static_cast<uint8_t>(priority), update.due_in) ? 1 : 0;
+    JournalCustomerOrder(received_ns, now, MSG_CUSTOMER_ORDER_UPDATE, client->GetID(),
+        {update.order_id, 0, priority, update.due_in, rsp.updated});
+    TCPConn::TCPMsg rsp_msg;
+    rsp_msg.header.type = MSG_CUSTOMER_ORDER_UPDATE_RSP;
+    rsp_msg << rsp;
+    client->Send(rsp_msg);
 }
 
-void MESServer::CreateOrderBatch(const uint32_t num, const uint8_t product_type) const
+void MESServer::HandleCustomerOrderCancel(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+    const ST_CustomerOrderCancel& cancel, const uint64_t received_ns) const
 {
-    if (!process_manager_->HasProduct(product_type))
-    {
-        ERROR_MSG("[MES] Cannot create order batch: product type {} is not configured", product_type);
-        return;
-    }
-    order_manager_->AddProductionTarget(product_type, num);
+    const auto now = SetMessageTime(received_ns);
+    const ST_CustomerOrderCancelRsp rsp{cancel.order_id, core_->CancelCustomerOrder(cancel.order_id) ? 1u : 0u};
+    JournalCustomerOrder(received_ns, now, MSG_CUSTOMER_ORDER_CANCEL, client->GetID(),
+        {cancel.order_id, 0, 0, 0.0f, rsp.cancelled});
+    TCPConn::TCPMsg rsp_msg;
+    rsp_msg.header.type = MSG_CUSTOMER_ORDER_CANCEL_RSP;
+    rsp_msg << rsp;
+    client->Send(rsp_msg);
 }
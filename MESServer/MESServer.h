@@ -7,18 +7,28 @@
 
 #include "TCPServer.h"
 #include "mes_server_def.h"
-#include "GraphManager.h"
-#include "OrderManager.h"
-#include "ProcessManager.h"
+#include "MESCore.h"
+#include "ShardedExecutor.h"
+#include "QueryJournal.h"
+#include "ThreadPool.h"
+#include <string>
 
+// Optional MES server behaviour, read from the `mes_service` section of the server config
+struct ST_MESServerOptions : ST_MESCoreOptions
+{
+    uint32_t dispatch_threads = 0;      // station query workers sharded by tray ID, 0 to handle queries on the network thread
+    std::string trace_file = "mes_trace.json";     // written on MSG_MES_TRACE_DUMP_QUERY
+    std::string journal_file;           // station queries and decisions are journaled here for replay, empty to disable
+};
+
+// TCP front end of the MES: decodes client messages and answers them through MESCore
 class MESServer : public TCPConn::ITCPServer<TCPConn::TCPMsg>
 {
-    friend class ProcessManager;
-    friend class OrderManager;
 public:
-    MESServer(uint16_t port, const json & j_graph, const json & j_capabilities, const json & j_products);
+    MESServer(uint16_t port, const json & j_graph, const json & j_capabilities, const json & j_products,
+        const ST_MESServerOptions & options = {});
 
-    ~MESServer() override = default;
+    ~MESServer() override;
 
     // Communication interfaces
     bool OnClientConnectionRequest(std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>> client) override;
@@ -26,24 +36,43 @@ public:
     void OnClientDisconnected(std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>> client) override;
     void OnMessage(std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>> client, TCPConn::TCPMsg& msg) override;
 
+    [[nodiscard]] MESCore & GetCore() const { return *core_; }
 
-    // Control policies
-    ST_StationActionRsp OnStationActionQuery(const ST_StationActionQuery& qry);
-    ST_StationActionRsp OnStationActionDoneQuery(const ST_StationActionQuery& qry);
-    bool FindNextStationToTargetStation(const uint32_t & current_station, const uint32_t & target_station, uint32_t & out) const;
-    bool PlanRouteToProcessStation(uint32_t current_station, ST_ProcessInfo process, uint32_t & out_next_station) const;
-    [[nodiscard]] uint32_t CalculateDefaultNextStation(const uint32_t & current_station) const;
-
-    ST_TrayInfo & GetTrayInfo(uint32_t tray_id);
+protected:
+    // received_ns is the arrival time of the query, the latency metric runs until the reply is sent
+    void HandleStationQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+        uint32_t msg_type, const ST_StationActionQuery& qry, uint64_t received_ns);
+    void HandleStationBatchQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+        std::vector<ST_StationActionBatchItem> items, uint64_t received_ns);
+    void SendRoutePush(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+        const ST_StationRoutePush& push);
+    void HandleOrderEtaQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+        const ST_OrderEtaQuery& qry, uint64_t received_ns);
+    static void HandleStatsQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client);
+    // The events are copied on the calling thread, the file is written and the reply sent by trace_writer_
+    void HandleTraceDumpQuery(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client, uint64_t received_ns);
+    void HandleCustomerOrderSubmit(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+        const ST_CustomerOrderSubmit& submit, uint64_t received_ns) const;
+    void HandleCustomerOrderUpdate(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+        const ST_CustomerOrderUpdate& update, uint64_t received_ns) const;
+    void HandleCustomerOrderCancel(const std::shared_ptr<TCPConn::ITCPConn<TCPConn::TCPMsg>>& client,
+        const ST_CustomerOrderCancel& cancel, uint64_t received_ns) const;
 
-    void CreateOrderBatch(uint32_t num, uint8_t product_type) const;
+    // The MES clock of the calling thread reads the arrival time of the message being handled, so a
+    // decision sees one time throughout and the journal records the time it was taken at
+    double SetMessageTime(uint64_t received_ns) const;
+    void JournalDecision(uint64_t received_ns, double now, uint32_t msg_type, uint32_t client_id,
+        const ST_StationActionQuery& qry, const ST_StationActionRsp& rsp) const;
+    void JournalCustomerOrder(uint64_t received_ns, double now, uint32_t msg_type, uint32_t client_id,
+        const ST_JournalCustomerOrder& order) const;
 
-protected:
-    std::unique_ptr<GraphManager> graph_manager_;
-    std::unique_ptr<ProcessManager> process_manager_;
-    std::unique_ptr<OrderManager> order_manager_;
+    std::unique_ptr<MESCore> core_;
+    std::unique_ptr<QueryJournalWriter> journal_;
+    std::string trace_file_;
+    std::unique_ptr<ThreadPool> trace_writer_;      // one thread, so dumps write the file in turn
 
-    std::unordered_map<uint32_t, ST_TrayInfo> tray_info_dict_;
+    // Declared last so it is destroyed first
+    std::unique_ptr<ShardedExecutor> dispatcher_;
 };
 
 
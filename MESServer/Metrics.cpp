@@ -0,0 +1,144 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "Metrics.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+
+namespace MESMetrics
+{
+    uint32_t LatencyHistogram::BucketIndex(uint64_t ns) noexcept
+    {
+        // Values below 2 * kSubBuckets map one to one, above that each power of two gets kSubBuckets buckets
+        constexpr uint64_t max_value = (uint64_t{1} << (kMaxExponent + 1)) - 1;
+        ns = std::min(ns, max_value);
+        if (ns < 2 * kSubBuckets)
+            return static_cast<uint32_t>(ns);
+        const auto shift = static_cast<uint32_t>(std::bit_width(ns)) - 1 - kSubBucketBits;
+        return (shift + 1) * kSubBuckets + static_cast<uint32_t>((ns >> shift) - kSubBuckets);
+    }
+
+    uint64_t LatencyHistogram::BucketUpperBound(const uint32_t index) noexcept
+    {
+        if (index < 2 * kSubBuckets)
+            return index;
+        const uint32_t shift = index / kSubBuckets - 1;
+        const uint64_t sub = index % kSubBuckets + kSubBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::Record(const uint64_t ns) noexcept
+    {
+        buckets_[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    uint64_t LatencyHistogram::Count() const noexcept
+    {
+        // The count is summed when read so that recording stays cheap
+        uint64_t total = 0;
+        for (const auto & b : buckets_)
+            total += b.load(std::memory_order_relaxed);
+        return total;
+    }
+
+    uint64_t LatencyHistogram::ValueAtQuantile(const double q) const noexcept
+    {
+        // Buckets are read one by one while others record, the answer is consistent to within those updates
+        const uint64_t total = Count();
+        if (total == 0)
+            return 0;
+        const auto rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * static_cast<double>(total))));
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < kNumBuckets; ++i)
+        {
+            seen += buckets_[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+                return BucketUpperBound(i);
+        }
+        return BucketUpperBound(kNumBuckets - 1);
+    }
+
+    Registry& Registry::Instance()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    Counter& Registry::GetCounter(const std::string& name, const std::string& help, const std::string& labels)
+    {
+        std::lock_guard lock(mutex_);
+        auto & family = families_[name];
+        family.help = help;
+        for (const auto & [l, series] : family.series)
+        {
+            if (l == labels)
+                return *static_cast<Counter*>(series);
+        }
+        auto & counter = counters_.emplace_back();
+        family.series.emplace_back(labels, &counter);
+        return counter;
+    }
+
+    LatencyHistogram& Registry::GetHistogram(const std::string& name, const std::string& help, const std::string& labels)
+    {
+        std::lock_guard lock(mutex_);
+        auto & family = families_[name];
+        family.help = help;
+        family.is_histogram = true;
+        for (const auto & [l, series] : family.series)
+        {
+            if (l == labels)
+                return *static_cast<LatencyHistogram*>(series);
+        }
+        auto & histogram = histograms_.emplace_back();
+        family.series.emplace_back(labels, &histogram);
+        return histogram;
+    }
+
+    std::string Registry::RenderPrometheus() const
+    {
+        constexpr double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+        const auto join = [](const std::string & labels, const std::string & extra) {
+            if (labels.empty() && extra.empty())
+                return std::string();
+            if (labels.empty() || extra.empty())
+                return "{" + labels + extra + "}";
+            return "{" + labels + "," + extra + "}";
+        };
+        const auto seconds = [](const uint64_t ns) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(ns) * 1e-9);
+            return std::string(buf);
+        };
+
+        std::lock_guard lock(mutex_);
+        std::string out;
+        for (const auto & [name, family] : families_)
+        {
+            out += "# HELP " + name + " " + family.help + "\n";
+            out += "# TYPE " + name + (family.is_histogram ? " summary\n" : " counter\n");
+            for (const auto & [labels, series] : family.series)
+            {
+                if (!family.is_histogram)
+                {
+                    out += name + join(labels, "") + " " + std::to_string(static_cast<const Counter*>(series)->Value()) + "\n";
+                    continue;
+                }
+                const auto & histogram = *static_cast<const LatencyHistogram*>(series);
+                for (const auto q : quantiles)
+                {
+                    char quantile[32];
+                    std::snprintf(quantile, sizeof(quantile), "quantile=\"%g\"", q);
+                    out += name + join(labels, quantile) + " " + seconds(histogram.ValueAtQuantile(q)) + "\n";
+                }
+                out += name + "_sum" + join(labels, "") + " " + seconds(histogram.SumNs()) + "\n";
+                out += name + "_count" + join(labels, "") + " " + std::to_string(histogram.Count()) + "\n";
+            }
+        }
+        return out;
+    }
+}
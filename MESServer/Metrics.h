@@ -0,0 +1,126 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_METRICS_H
+#define RECONFIGMANUS_METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timers and counters inside the decision core, 0 compiles them out
+#ifndef MES_METRICS
+#define MES_METRICS 1
+#endif
+
+namespace MESMetrics
+{
+    inline uint64_t NowNs() noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    class Counter
+    {
+    public:
+        void Inc(const uint64_t n = 1) noexcept { value_.fetch_add(n, std::memory_order_relaxed); }
+        uint64_t Value() const noexcept { return value_.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> value_{0};
+    };
+
+    // Log-linear latency histogram in nanoseconds, HDR style: 16 linear sub-buckets per power of two keep
+    // the relative error of any recorded value under 1/16. Recording is two relaxed atomic adds.
+    class LatencyHistogram
+    {
+    public:
+        static constexpr uint32_t kSubBucketBits = 4;
+        static constexpr uint32_t kSubBuckets = 1u << kSubBucketBits;
+        static constexpr uint32_t kMaxExponent = 40;     // values above 2^41 ns (~36 min) are clamped
+        static constexpr uint32_t kNumBuckets = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+        void Record(uint64_t ns) noexcept;
+        uint64_t Count() const noexcept;
+        uint64_t SumNs() const noexcept { return sum_ns_.load(std::memory_order_relaxed); }
+        // Upper bound of the bucket holding quantile q in [0, 1], 0 when empty
+        uint64_t ValueAtQuantile(double q) const noexcept;
+
+        static uint32_t BucketIndex(uint64_t ns) noexcept;
+        static uint64_t BucketUpperBound(uint32_t index) noexcept;
+
+    private:
+        std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+        std::atomic<uint64_t> sum_ns_{0};
+    };
+
+    // Records the lifetime of the scope into a histogram
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(LatencyHistogram & histogram) noexcept : histogram_(histogram), start_ns_(NowNs()) {}
+        ~ScopedTimer() { histogram_.Record(NowNs() - start_ns_); }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        LatencyHistogram & histogram_;
+        uint64_t start_ns_;
+    };
+
+    // Process-wide metrics. Registration takes a lock and returns a reference that stays valid for the
+    // process lifetime, so call sites look their metric up once and update it lock-free afterwards.
+    class Registry
+    {
+    public:
+        static Registry& Instance();
+
+        // labels is the Prometheus label list without braces, e.g. type="station_action_query"
+        Counter& GetCounter(const std::string& name, const std::string& help, const std::string& labels = "");
+        LatencyHistogram& GetHistogram(const std::string& name, const std::string& help, const std::string& labels = "");
+
+        // Prometheus text exposition. Histograms are exported as summaries in seconds.
+        std::string RenderPrometheus() const;
+
+    private:
+        Registry() = default;
+
+        struct ST_Family
+        {
+            std::string help;
+            bool is_histogram = false;
+            std::vector<std::pair<std::string, void*>> series;     // labels, Counter or LatencyHistogram
+        };
+
+        mutable std::mutex mutex_;
+        std::map<std::string, ST_Family> families_;
+        std::deque<Counter> counters_;
+        std::deque<LatencyHistogram> histograms_;
+    };
+}
+
+#define MES_METRIC_CONCAT_(a, b) a##b
+#define MES_METRIC_CONCAT(a, b) MES_METRIC_CONCAT_(a, b)
+
+#if MES_METRICS
+// Times the rest of the enclosing scope. name and help must be string literals.
+#define MES_METRIC_TIME_SCOPE(name, help) \
+    static auto & MES_METRIC_CONCAT(mes_metric_hist_, __LINE__) = MESMetrics::Registry::Instance().GetHistogram(name, help); \
+    const MESMetrics::ScopedTimer MES_METRIC_CONCAT(mes_metric_timer_, __LINE__)(MES_METRIC_CONCAT(mes_metric_hist_, __LINE__))
+#define MES_METRIC_COUNT(name, help, labels) \
+    do { static auto & mes_metric_counter = MESMetrics::Registry::Instance().GetCounter(name, help, labels); \
+         mes_metric_counter.Inc(); } while (0)
+#else
+#define MES_METRIC_TIME_SCOPE(name, help) ((void)0)
+#define MES_METRIC_COUNT(name, help, labels) ((void)0)
+#endif
+
+#endif //RECONFIGMANUS_METRICS_H
@@ -4,127 +4,263 @@
 
 #include "OrderManager.h"
 #include <algorithm>
-#include "LogMacros.h"
+#include "AsyncLogger.h"
+#include "Metrics.h"
+
+OrderManager::OrderManager(const uint64_t seed, const OrderReleasePolicy release_policy, const DispatchRule dispatch_rule)
+    : remaining_order_targets_(release_policy), customer_orders_(dispatch_rule)
+{
+    std::seed_seq seq{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+    rng_.seed(seq);
+}
 
 uint32_t OrderManager::CreateNewOrder(uint8_t product_type)
+{
+    std::lock_guard lock(mutex_);
+    return InsertNewOrder(product_type);
+}
+
+uint32_t OrderManager::InsertNewOrder(uint8_t product_type)
 {
     const uint32_t new_order_id = ++cur_order_id_;
-    order_pool_[new_order_id] = Order{ new_order_id, product_type, UINT32_MAX, ORDER_WAIT };
+    uint32_t slot;
+    if (!free_slots_.empty())
+    {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(order_slots_.size());
+        order_slots_.emplace_back();
+    }
+    // Reuse the history buffer of the previous occupant
+    auto history = std::move(order_slots_[slot].order.executed_processes);
+    history.clear();
+    order_slots_[slot].order = Order{ new_order_id, product_type, UINT32_MAX, ORDER_WAIT, std::move(history) };
+    live_orders_.emplace(new_order_id, slot);
     return new_order_id;
 }
 
+Order * OrderManager::FindLiveOrder(const uint32_t order_id)
+{
+    const auto it = live_orders_.find(order_id);
+    return it != live_orders_.end() ? &order_slots_[it->second].order : nullptr;
+}
+
+const Order * OrderManager::FindLiveOrder(const uint32_t order_id) const
+{
+    const auto it = live_orders_.find(order_id);
+    return it != live_orders_.end() ? &order_slots_[it->second].order : nullptr;
+}
+
+void OrderManager::LinkRunning(const uint32_t slot)
+{
+    auto & entry = order_slots_[slot];
+    if (entry.running)
+        return;
+    entry.prev_running = no_slot;
+    entry.next_running = running_head_;
+    if (running_head_ != no_slot)
+        order_slots_[running_head_].prev_running = slot;
+    running_head_ = slot;
+    entry.running = true;
+    ++running_count_;
+}
+
+void OrderManager::UnlinkRunning(const uint32_t slot)
+{
+    auto & entry = order_slots_[slot];
+    if (!entry.running)
+        return;
+    if (entry.prev_running != no_slot)
+        order_slots_[entry.prev_running].next_running = entry.next_running;
+    else
+        running_head_ = entry.next_running;
+    if (entry.next_running != no_slot)
+        order_slots_[entry.next_running].prev_running = entry.prev_running;
+    entry.prev_running = entry.next_running = no_slot;
+    entry.running = false;
+    --running_count_;
+}
+
+void OrderManager::ArchiveOrder(const uint32_t slot)
+{
+    const auto & order = order_slots_[slot].order;
+    archived_orders_.push_back({order.order_id, order.tray_id, static_cast<uint32_t>(archived_processes_.size()),
+        static_cast<uint32_t>(order.executed_processes.size()), order.product_type, static_cast<uint8_t>(order.status)});
+    archived_processes_.insert(archived_processes_.end(), order.executed_processes.begin(), order.executed_processes.end());
+    live_orders_.erase(order.order_id);
+    free_slots_.push_back(slot);
+}
+
 void OrderManager::AddProductionTarget(const uint8_t product_type, const uint32_t count)
 {
+    std::lock_guard lock(mutex_);
     if (count == 0)
         return;
 
-    remaining_order_targets_[product_type] += count;
-    total_remaining_order_targets_ += count;
+    remaining_order_targets_.Add(product_type, count);
+}
+
+uint32_t OrderManager::SubmitCustomerOrder(const uint8_t product_type, const uint8_t priority, const double due_time)
+{
+    std::lock_guard lock(mutex_);
+    const auto order_id = InsertNewOrder(product_type);
+    customer_orders_.Push({order_id, product_type, priority, due_time});
+    return order_id;
+}
+
+bool OrderManager::UpdateCustomerOrder(const uint32_t order_id, const uint8_t priority, const double due_time)
+{
+    std::lock_guard lock(mutex_);
+    return customer_orders_.Update(order_id, priority, due_time);
+}
+
+bool OrderManager::CancelCustomerOrder(const uint32_t order_id)
+{
+    std::lock_guard lock(mutex_);
+    if (!customer_orders_.Remove(order_id))
+        return false;
+    const auto slot = live_orders_.at(order_id);
+    order_slots_[slot].order.status = ORDER_DELETE;
+    ArchiveOrder(slot);
+    return true;
+}
+
+void OrderManager::SetExpectedRouteTime(const uint8_t product_type, const double time)
+{
+    std::lock_guard lock(mutex_);
+    customer_orders_.SetExpectedRouteTime(product_type, time);
 }
 
 bool OrderManager::GetOrderByID(uint32_t order_id, Order& order) const
 {
+    std::lock_guard lock(mutex_);
     // Return Read-only order info
-    if (const auto it = order_pool_.find(order_id); it != order_pool_.end())
+    if (const auto * live = FindLiveOrder(order_id))
     {
-        order = it->second;
+        order = *live;
         return true;
     }
-    return false;
+    const auto it = std::ranges::find(archived_orders_, order_id, &ST_ArchivedOrder::order_id);
+    if (it == archived_orders_.end())
+        return false;
+    const auto history = archived_processes_.begin() + it->history_offset;
+    order = Order{ it->order_id, it->product_type, it->tray_id, static_cast<ORDER_RUN_STATUS>(it->status),
+        std::vector<ST_ProcessInfo>(history, history + it->history_length), Order::off_routing };
+    return true;
+}
+
+bool OrderManager::GetOrderProgress(const uint32_t order_id, ST_OrderProgress& out) const
+{
+    std::lock_guard lock(mutex_);
+    const auto * order = FindLiveOrder(order_id);
+    if (order == nullptr)
+        return false;
+    out = {order->product_type, order->tray_id, order->status, order->next_step};
+    return true;
 }
 
 size_t OrderManager::GetWaitOrderNum() const
 {
-    return total_remaining_order_targets_;
+    std::lock_guard lock(mutex_);
+    return remaining_order_targets_.Total() + customer_orders_.Size();
 }
 
-bool OrderManager::IsOrderDone(uint32_t order_id)
+size_t OrderManager::GetPendingCustomerOrderNum() const
 {
-    auto it = order_pool_.find(order_id);
-    if (it == order_pool_.end())
-    {
-        ERROR_MSG("[ORDER] Failed to get order by id");
-        return false;
-    }
-    return it->second.status == ORDER_FINISHED;
+    std::lock_guard lock(mutex_);
+    return customer_orders_.Size();
 }
 
-bool OrderManager::TryAssignNewOrderToTray(uint32_t tray_id, uint32_t& order_id)
+size_t OrderManager::GetRunningOrderNum() const
 {
-    if (GetWaitOrderNum() == 0)
-    {
-        INFO_MSG("[ORDER] No order to be assigned");
-        return false;
-    }
+    std::lock_guard lock(mutex_);
+    return running_count_;
+}
 
-    std::uniform_int_distribution<uint32_t> distribution(1, total_remaining_order_targets_);
-    uint32_t pick = distribution(rng_);
-    uint8_t selected_product_type = UINT8_MAX;
-    for (auto & [product_type, remaining_count] : remaining_order_targets_)
-    {
-        if (remaining_count == 0)
-            continue;
-
-        if (pick <= remaining_count)
-        {
-            selected_product_type = product_type;
-            --remaining_count;
-            --total_remaining_order_targets_;
-            break;
-        }
-        pick -= remaining_count;
-    }
+size_t OrderManager::GetFinishedOrderNum() const
+{
+    std::lock_guard lock(mutex_);
+    return archived_orders_.size();
+}
+
+bool OrderManager::IsOrderDone(uint32_t order_id)
+{
+    std::lock_guard lock(mutex_);
+    if (const auto * order = FindLiveOrder(order_id))
+        return order->status == ORDER_FINISHED;
+    if (const auto it = std::ranges::find(archived_orders_, order_id, &ST_ArchivedOrder::order_id); it != archived_orders_.end())
+        return it->status == ORDER_FINISHED;
+    MES_LOG_ERROR("[ORDER] Failed to get order by id");
+    return false;
+}
 
-    if (selected_product_type == UINT8_MAX)
+bool OrderManager::TryAssignNewOrderToTray(uint32_t tray_id, uint32_t& order_id, const double now,
+    const ProductTypeSet * admitted)
+{
+    MES_METRIC_TIME_SCOPE("mes_order_assign_seconds", "Time spent in OrderManager::TryAssignNewOrderToTray");
+    std::lock_guard lock(mutex_);
+    uint8_t selected_product_type;
+    // Customer orders first, then the production targets
+    if (ST_CustomerOrder customer_order; customer_orders_.Pop(now, customer_order, admitted))
     {
-        ERROR_MSG("[ORDER] Failed to select product type for new order");
-        return false;
+        order_id = customer_order.order_id;
+        selected_product_type = customer_order.product_type;
     }
-
-    order_id = CreateNewOrder(selected_product_type);
-    running_orders_.push_back(order_id);
-
-    auto it = order_pool_.find(order_id);
-    if (it == order_pool_.end())
+    else if (remaining_order_targets_.Take(rng_, selected_product_type, admitted))
+        order_id = InsertNewOrder(selected_product_type);
+    else
     {
-        ERROR_MSG("[ORDER] Failed to get order by id");
+        MES_LOG_INFO("[ORDER] No order to be assigned");
         return false;
     }
-    it->second.tray_id = tray_id;
-    it->second.status = ORDER_EXECUTING;
 
-    INFO_MSG("[ORDER] Order {} of product type {} assigned to tray {}", order_id, selected_product_type, tray_id);
+    const auto slot = live_orders_.at(order_id);
+    LinkRunning(slot);
+    auto & order = order_slots_[slot].order;
+    order.tray_id = tray_id;
+    order.status = ORDER_EXECUTING;
+
+    MES_LOG_INFO("[ORDER] Order {} of product type {} assigned to tray {}", order_id, selected_product_type, tray_id);
 
     return true;
 }
 
-void OrderManager::OnOrderProcessSuccess(const uint32_t order_id, const ST_ProcessInfo& process)
+void OrderManager::OnOrderProcessSuccess(const uint32_t order_id, const ST_ProcessInfo& process, const bool follows_routing)
 {
-    auto it = order_pool_.find(order_id);
-    if (it == order_pool_.end())
+    std::lock_guard lock(mutex_);
+    auto * live = FindLiveOrder(order_id);
+    if (live == nullptr)
     {
-        ERROR_MSG("[ORDER] Failed to get order by id");
+        MES_LOG_ERROR("[ORDER] Failed to get order by id");
         return;
     }
-    it->second.executed_processes.push_back(process);
+    auto & order = *live;
+    order.executed_processes.push_back(process);
+    if (follows_routing && order.next_step != Order::off_routing)
+        ++order.next_step;
+    else
+        order.next_step = Order::off_routing;
 }
 
 void OrderManager::UpdateOrderStatus(uint32_t order_id)
 {
+    std::lock_guard lock(mutex_);
     // Mark order as finished successfully for now
-    const auto it = order_pool_.find(order_id);
-    if (it == order_pool_.end())
+    const auto it = live_orders_.find(order_id);
+    if (it == live_orders_.end())
     {
-        ERROR_MSG("[ORDER] UpdateOrderStatus: order {} not found", order_id);
+        MES_LOG_ERROR("[ORDER] UpdateOrderStatus: order {} not found", order_id);
         return;
     }
+    const auto slot = it->second;
 
-    // Update status in pool
-    it->second.status = ORDER_FINISHED;
-
-    // Move from running to finished lists
-    running_orders_.remove(order_id);
-    finished_orders_.push_back(order_id);
+    // Update status, then move the order from the running set to the archive
+    order_slots_[slot].order.status = ORDER_FINISHED;
+    UnlinkRunning(slot);
+    ArchiveOrder(slot);
 
-    INFO_MSG("[ORDER] Order {} marked as FINISHED", order_id);
+    MES_LOG_INFO("[ORDER] Order {} marked as FINISHED", order_id);
 }
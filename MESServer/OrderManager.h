@@ -6,49 +6,126 @@
 #define RECONFIGMANUS_ORDERMANAGER_H
 
 #include <atomic>
-#include <list>
 #include <memory>
+#include <mutex>
 #include <random>
 #include <unordered_map>
+#include <vector>
 #include "mes_server_def.h"
+#include "CustomerOrderQueue.h"
+#include "ProductMix.h"
 
 
 struct Order
 {
+    static constexpr uint32_t off_routing = UINT32_MAX;
+
     uint32_t order_id;
     uint8_t product_type;
     uint32_t tray_id;
     ORDER_RUN_STATUS status;
-    std::vector<ST_ProcessInfo> executed_processes{};
+    std::vector<ST_ProcessInfo> executed_processes{};   // full history, for auditing
+    uint32_t next_step = 0;     // index of the next process in the product routing, off_routing once it diverged
+};
+
+// The fields of an order needed on every decision, read without copying the history
+struct ST_OrderProgress
+{
+    uint8_t product_type;
+    uint32_t tray_id;
+    ORDER_RUN_STATUS status;
+    uint32_t next_step;
 };
 
+// Thread-safe, every public method runs under the manager's lock.
+// Live orders sit in a slab of reusable slots, so the pool only grows to the peak WIP. Finished orders
+// move to a compact append-only archive.
+// Customer orders carry a priority and a due time and are released before the production targets,
+// in the order of the dispatch rule.
 class OrderManager
 {
     friend class MES_Server;
 public:
     OrderManager() = default;
+    // Deterministic order assignment for the same sequence of queries
+    explicit OrderManager(uint64_t seed, OrderReleasePolicy release_policy = OrderReleasePolicy::weighted_random,
+        DispatchRule dispatch_rule = DispatchRule::edd);
     ~OrderManager() = default;
 
     uint32_t CreateNewOrder(uint8_t product_type);
     void AddProductionTarget(uint8_t product_type, uint32_t count);
 
+    // Customer orders wait in ORDER_WAIT until released to a tray, due times are on the MES clock
+    uint32_t SubmitCustomerOrder(uint8_t product_type, uint8_t priority, double due_time);
+    bool UpdateCustomerOrder(uint32_t order_id, uint8_t priority, double due_time);
+    // Only orders not released yet, a cancelled order is archived as ORDER_DELETE
+    bool CancelCustomerOrder(uint32_t order_id);
+    void SetExpectedRouteTime(uint8_t product_type, double time);
+
+    // Live orders first, finished orders are looked up in the archive by a linear scan
     bool GetOrderByID(uint32_t order_id, Order& order) const;
+    // Live orders only
+    bool GetOrderProgress(uint32_t order_id, ST_OrderProgress& out) const;
+    // Pending customer orders plus remaining production targets
     size_t GetWaitOrderNum() const;
+    size_t GetPendingCustomerOrderNum() const;
+    size_t GetRunningOrderNum() const;
+    size_t GetFinishedOrderNum() const;
     bool IsOrderDone(uint32_t order_id);
 
-    bool TryAssignNewOrderToTray(uint32_t tray_id, uint32_t& order_id);
-    void OnOrderProcessSuccess(uint32_t order_id, const ST_ProcessInfo& process);
+    // now is the MES clock, used by the critical ratio rule. With admitted given, only orders of those
+    // product types are released.
+    bool TryAssignNewOrderToTray(uint32_t tray_id, uint32_t& order_id, double now = 0.0,
+        const ProductTypeSet * admitted = nullptr);
+    // follows_routing: the process is the next step of the product routing, the cursor advances.
+    // Otherwise the order is off its routing and has no next process.
+    void OnOrderProcessSuccess(uint32_t order_id, const ST_ProcessInfo& process, bool follows_routing);
     void UpdateOrderStatus(uint32_t order_id);
 
 protected:
+    static constexpr uint32_t no_slot = UINT32_MAX;
+
+    // Slab entry, running orders are linked through it so they are unlinked in O(1)
+    struct ST_OrderSlot
+    {
+        Order order{};
+        uint32_t prev_running = no_slot;
+        uint32_t next_running = no_slot;
+        bool running = false;
+    };
 
+    // Finished order, its executed processes are stored in archived_processes_
+    struct ST_ArchivedOrder
+    {
+        uint32_t order_id;
+        uint32_t tray_id;
+        uint32_t history_offset;
+        uint32_t history_length;
+        uint8_t product_type;
+        uint8_t status;
+    };
+
+    // Callers hold mutex_
+    uint32_t InsertNewOrder(uint8_t product_type);
+    Order * FindLiveOrder(uint32_t order_id);
+    const Order * FindLiveOrder(uint32_t order_id) const;
+    void LinkRunning(uint32_t slot);
+    void UnlinkRunning(uint32_t slot);
+    void ArchiveOrder(uint32_t slot);
+
+    mutable std::mutex mutex_;
     std::atomic<uint32_t> cur_order_id_ = 0;
-    std::unordered_map<uint32_t, Order> order_pool_;
-    std::unordered_map<uint8_t, uint32_t> remaining_order_targets_;
-    uint32_t total_remaining_order_targets_ = 0;
+    ProductMix remaining_order_targets_;
+    CustomerOrderQueue customer_orders_;
+
+    std::vector<ST_OrderSlot> order_slots_;
+    std::vector<uint32_t> free_slots_;                      // recycled slots keep their history capacity
+    std::unordered_map<uint32_t, uint32_t> live_orders_;    // order ID -> slot
+    uint32_t running_head_ = no_slot;
+    size_t running_count_ = 0;
 
-    std::list<uint32_t> running_orders_;
-    std::list<uint32_t> finished_orders_;
+    std::vector<ST_ArchivedOrder> archived_orders_;
+    std::vector<ST_ProcessInfo> archived_processes_;
     mutable std::mt19937 rng_{std::random_device{}()};
 
 };
@@ -0,0 +1,164 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "PlantGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+bool PlantTopologyFromString(const std::string & s, PlantTopology & out) noexcept
+{
+    if (s == "ring") out = PlantTopology::ring;
+    else if (s == "grid") out = PlantTopology::grid;
+    else if (s == "pools") out = PlantTopology::pools;
+    else return false;
+    return true;
+}
+
+const char * PlantTopologyToString(const PlantTopology t) noexcept
+{
+    switch (t)
+    {
+        case PlantTopology::grid: return "grid";
+        case PlantTopology::pools: return "pools";
+        default: return "ring";
+    }
+}
+
+namespace
+{
+    json TimeDistToJson(const ST_TimeDist & dist, const double scale)
+    {
+        // Scale location and spread alike, so e.g. triangular bounds keep their order
+        std::vector<double> parameters = dist.parameters;
+        if (dist.type == TimeDistType::weibull && parameters.size() >= 2)
+            parameters[1] *= scale;     // shape, scale: only the scale parameter carries time
+        else
+            for (auto & p : parameters)
+                p *= scale;
+        return {{"type", TimeDistTypeToString(dist.type)}, {"parameters", parameters}};
+    }
+
+    class PlantBuilder
+    {
+    public:
+        explicit PlantBuilder(const ST_PlantSpec & spec)
+            : spec_(spec), rng_(spec.seed), jitter_(1.0 - spec.time_jitter, 1.0 + spec.time_jitter)
+        {
+            model_.graph = {{"vertices", json::array()}, {"arcs", json::array()}};
+            model_.capabilities = {{"stations", json::array()}};
+        }
+
+        // process 0 for a station without process capability
+        void AddStation(const uint32_t id, const uint32_t process)
+        {
+            const auto name = "S" + std::to_string(id);
+            model_.graph["vertices"].push_back({{"id", id}, {"name", name}, {"buffer_capacity", spec_.buffer_capacity},
+                {"service_time_distribution", TimeDistToJson(spec_.service_time, Jitter())}});
+            json station = {{"id", id}, {"name", name}, {"is_order_assigning_station", id == 1}};
+            if (process != 0)
+                station["process_capability"] = process;
+            model_.capabilities["stations"].push_back(std::move(station));
+        }
+
+        void AddArc(const uint32_t tail, const uint32_t head, const double length = 1.0)
+        {
+            model_.graph["arcs"].push_back({{"tail", tail}, {"head", head},
+                {"transfer_time_distribution", TimeDistToJson(spec_.transfer_time, length * Jitter())}});
+        }
+
+        ST_PlantModel Finish()
+        {
+            json processes = json::array();
+            for (uint32_t p = 1; p <= spec_.num_processes; ++p)
+                processes.push_back({{"process_id", p}});
+            model_.products = {{"products", json::array({{{"product_type", 1},
+                {"product_name", std::string("Generated ") + PlantTopologyToString(spec_.topology) + " product"},
+                {"processes", std::move(processes)}}})}};
+            return std::move(model_);
+        }
+
+    private:
+        double Jitter() { return spec_.time_jitter > 0.0 ? jitter_(rng_) : 1.0; }
+
+        const ST_PlantSpec & spec_;
+        std::mt19937_64 rng_;
+        std::uniform_real_distribution<double> jitter_;
+        ST_PlantModel model_;
+    };
+}
+
+bool GeneratePlant(const ST_PlantSpec & spec, ST_PlantModel & out)
+{
+    if (spec.num_processes == 0 || spec.num_processes > 255 || spec.num_stations < 2)
+        return false;
+    PlantBuilder builder(spec);
+    const uint32_t n = spec.num_stations;
+    const auto round_robin = [&spec](const uint32_t id) { return (id - 1) % spec.num_processes + 1; };
+
+    switch (spec.topology)
+    {
+        case PlantTopology::grid:
+        {
+            const uint32_t width = spec.grid_width > 0
+                ? spec.grid_width : std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(std::sqrt(n))));
+            for (uint32_t id = 1; id <= n; ++id)
+                builder.AddStation(id, round_robin(id));
+            for (uint32_t id = 1; id <= n; ++id)
+            {
+                const uint32_t col = (id - 1) % width;
+                if (col + 1 < width && id + 1 <= n)
+                {
+                    builder.AddArc(id, id + 1);
+                    builder.AddArc(id + 1, id);
+                }
+                if (id + width <= n)
+                {
+                    builder.AddArc(id, id + width);
+                    builder.AddArc(id + width, id);
+                }
+            }
+            break;
+        }
+        case PlantTopology::ring:
+        {
+            for (uint32_t id = 1; id <= n; ++id)
+                builder.AddStation(id, round_robin(id));
+            for (uint32_t id = 1; id <= n; ++id)
+            {
+                builder.AddArc(id, id % n + 1);
+                // Chords jump half way round, they are longer than one hop but save many
+                if (spec.chord_every > 0 && id % spec.chord_every == 0 && n > 2 * spec.chord_every)
+                    builder.AddArc(id, (id + n / 2 - 1) % n + 1, 2.5);
+            }
+            break;
+        }
+        case PlantTopology::pools:
+        {
+            // Station 1 loads and unloads, the rest is split evenly into one pool per process
+            const uint32_t pool_size = std::max<uint32_t>(1, (n - 1) / spec.num_processes);
+            builder.AddStation(1, 0);
+            uint32_t next_id = 2;
+            std::vector<uint32_t> previous_pool{1};
+            for (uint32_t p = 1; p <= spec.num_processes; ++p)
+            {
+                std::vector<uint32_t> pool;
+                for (uint32_t k = 0; k < pool_size; ++k)
+                {
+                    builder.AddStation(next_id, p);
+                    pool.push_back(next_id++);
+                }
+                for (const auto tail : previous_pool)
+                    for (const auto head : pool)
+                        builder.AddArc(tail, head);
+                previous_pool = std::move(pool);
+            }
+            for (const auto tail : previous_pool)
+                builder.AddArc(tail, 1);
+            break;
+        }
+    }
+    out = builder.Finish();
+    return true;
+}
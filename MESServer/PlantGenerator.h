@@ -0,0 +1,50 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_PLANTGENERATOR_H
+#define RECONFIGMANUS_PLANTGENERATOR_H
+
+#include "GraphDef.h"
+#include <nlohmann/json.hpp>
+#include <string>
+
+using json = nlohmann::json;
+
+enum class PlantTopology : uint8_t
+{
+    grid,       // bidirectional 4-neighbour grid, processes assigned round robin
+    ring,       // one-way ring with chords across the ring, processes assigned round robin
+    pools       // load station feeding one pool of parallel machines per process, pools chained in process order
+};
+
+// False for an unknown name, out is left unchanged
+bool PlantTopologyFromString(const std::string & s, PlantTopology & out) noexcept;
+const char * PlantTopologyToString(PlantTopology t) noexcept;
+
+struct ST_PlantSpec
+{
+    PlantTopology topology = PlantTopology::ring;
+    uint32_t num_stations = 100;
+    uint32_t num_processes = 5;
+    uint32_t grid_width = 0;            // 0 for a square-ish grid
+    uint32_t chord_every = 8;           // ring: a chord leaves every n-th station, 0 for none
+    uint8_t buffer_capacity = 3;
+    ST_TimeDist service_time{TimeDistType::triangular, {3.0, 8.0, 5.0}};
+    ST_TimeDist transfer_time{TimeDistType::normal, {10.0, 0.5}};
+    double time_jitter = 0.2;           // per station and arc scale factor drawn from [1 - j, 1 + j]
+    uint64_t seed = 1;
+};
+
+// Consistent graph, capabilities and products models in the formats read by MESServer. Station 1 is
+// the order assigning station, the single product (type 1) runs processes 1..num_processes in order.
+struct ST_PlantModel
+{
+    json graph;
+    json capabilities;
+    json products;
+};
+
+bool GeneratePlant(const ST_PlantSpec & spec, ST_PlantModel & out);
+
+#endif //RECONFIGMANUS_PLANTGENERATOR_H
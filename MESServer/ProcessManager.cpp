@@ -3,14 +3,14 @@
 //
 
 #include "ProcessManager.h"
-#include "LogMacros.h"
-#include "MESServer.h"
+#include "AsyncLogger.h"
 #include <algorithm>
 
-ProcessManager::ProcessManager(const std::shared_ptr<MESServer>& mes_server_ptr, const json& station_cfg, const json & products_cfg)
+ProcessManager::ProcessManager(const OrderManager& order_manager, const json& station_cfg, const json & products_cfg)
+    : order_manager_(order_manager)
 {
     // TODO check validity of the file
-    INFO_MSG("Loading station process configuration...");
+    MES_LOG_INFO("Loading station process configuration...");
     for (const auto & s : station_cfg["stations"])
     {
         // load process_capability
@@ -19,20 +19,18 @@ ProcessManager::ProcessManager(const std::shared_ptr<MESServer>& mes_server_ptr,
         {
             const auto cap_val = static_cast<ST_ProcessInfo>(s["process_capability"].get<uint32_t>());
             station_process_map_[station_id].push_back(cap_val);
+            process_station_map_[cap_val].push_back(station_id);
         }
         if (s["is_order_assigning_station"].get<bool>())
             order_assigning_stations_.push_back(station_id);
     }
 
-    INFO_MSG("Loading product configuration...");
+    MES_LOG_INFO("Loading product configuration...");
     for (const auto & product_json : products_cfg["products"])
     {
         Product product(product_json);
         products_.emplace(product.product_type, std::move(product));
     }
-
-    // MES
-    mes_server_ = mes_server_ptr;
 }
 
 bool ProcessManager::IsOrderAssigningStation(const uint32_t station_id) const
@@ -45,40 +43,29 @@ bool ProcessManager::IsOrderAssigningStation(const uint32_t station_id) const
 
 bool ProcessManager::GetNextProcessToExecute(const uint32_t order_id, ST_ProcessInfo& out) const
 {
-    Order order;
-    if (!mes_server_->order_manager_->GetOrderByID(order_id, order))
+    ST_OrderProgress progress;
+    if (!order_manager_.GetOrderProgress(order_id, progress))
     {
-        ERROR_MSG("[Process] order id does not exist");
+        MES_LOG_ERROR("[Process] order id does not exist");
         return false;
     }
-    const auto * product = GetProduct(order.product_type);
+    const auto * product = GetProduct(progress.product_type);
     if (product == nullptr)
     {
-        ERROR_MSG("[Process] product type {} does not exist", order.product_type);
+        MES_LOG_ERROR("[Process] product type {} does not exist", progress.product_type);
         return false;
     }
-    // Execution not started, return the first process
-    if (order.executed_processes.empty())
+    if (progress.next_step == Order::off_routing)
     {
-        ST_ProcessInfo process;
-        if (!product->GetFirstProcess(process))
-        {
-            ERROR_MSG("[Process] First process does not exist");
-            return false;
-        }
-        out = process;
-        return true;
+        MES_LOG_ERROR("[Process] Executed steps of order {} do not match the product routing", order_id);
+        return false;
     }
-    // Execution ongoing
-    std::vector<ST_ProcessInfo> remaining_process;
-    if (!product->GetRemainingProcesses(order, remaining_process))
+    // TODO Assume only sequential processes supported for now
+    if (!product->GetProcessAt(progress.next_step, out))
     {
-        INFO_MSG("[Process] Remaining process does not exist");
+        MES_LOG_INFO("[Process] Remaining process does not exist");
         return false;
     }
-    // TODO Assume only sequential processes supported for now
-    const auto process = remaining_process.front();
-    out = process;
     return true;
 }
 
@@ -87,14 +74,14 @@ bool ProcessManager::ProcessCanBeExecutedAtStation(const ST_ProcessInfo& process
     const auto it = station_process_map_.find(station);
     if (it == station_process_map_.end())
     {
-        ERROR_MSG("[Process] station {} not found or has no configured process capability", station);
+        MES_LOG_ERROR("[Process] station {} not found or has no configured process capability", station);
         return false;
     }
 
     const auto & capabilities = it->second;
     if (std::find(capabilities.begin(), capabilities.end(), process) == capabilities.end())
     {
-        INFO_MSG("[Process] process {} cannot be executed at station {}", process, station);
+        MES_LOG_INFO("[Process] process {} cannot be executed at station {}", process, station);
         return false;
     }
     return true;
@@ -104,22 +91,23 @@ bool ProcessManager::FindStationsForProcess(const ST_ProcessInfo& process, std::
 {
     out_stations.clear();
 
-    for (const auto & entry : station_process_map_)
-    {
-        const uint32_t station_id = entry.first;
-        const auto & capabilities = entry.second;
-        if (std::find(capabilities.begin(), capabilities.end(), process) != capabilities.end())
-        {
-            out_stations.push_back(station_id);
-        }
-    }
+    const auto * stations = GetStationsForProcess(process);
+    if (stations == nullptr)
+        return false;
 
-    if (out_stations.empty())
+    out_stations.assign(stations->begin(), stations->end());
+    return true;
+}
+
+const std::vector<uint32_t> * ProcessManager::GetStationsForProcess(const ST_ProcessInfo& process) const
+{
+    const auto it = process_station_map_.find(process);
+    if (it == process_station_map_.end() || it->second.empty())
     {
-        ERROR_MSG("[Process] No station can execute process {}", process);
-        return false;
+        MES_LOG_ERROR("[Process] No station can execute process {}", process);
+        return nullptr;
     }
-    return true;
+    return &it->second;
 }
 
 uint32_t ProcessManager::GetDefaultReturningStation() const
@@ -8,18 +8,19 @@
 #include <list>
 #include <unordered_map>
 #include <memory>
+#include <vector>
 #include "nlohmann/json.hpp"
 #include "ProductManager.h"
+#include "OrderManager.h"
 
-class MESServer; // forward declaration
 using json = nlohmann::json;
 
 class ProcessManager
 {
 public:
-    friend class MESServer;
+    friend class MESCore;
 
-    ProcessManager(const std::shared_ptr<MESServer>& mes_server_ptr, const json & station_cfg, const json & products_cfg);
+    ProcessManager(const OrderManager & order_manager, const json & station_cfg, const json & products_cfg);
     ~ProcessManager() = default;
 
     bool IsOrderAssigningStation(uint32_t station_id) const;
@@ -29,6 +30,7 @@ public:
     bool ProcessCanBeExecutedAtStation(const ST_ProcessInfo & process, uint32_t station) const;
 
     bool FindStationsForProcess(const ST_ProcessInfo & process, std::list<uint32_t> & out_stations) const;
+    const std::vector<uint32_t> * GetStationsForProcess(const ST_ProcessInfo & process) const;
 
     uint32_t GetDefaultReturningStation() const;
     bool HasProduct(uint8_t product_type) const;
@@ -36,11 +38,13 @@ public:
 protected:
     const Product * GetProduct(uint8_t product_type) const;
 
-    std::shared_ptr<MESServer> mes_server_;
+    const OrderManager & order_manager_;
 
     std::list<uint32_t> order_assigning_stations_;
 
     std::unordered_map<uint32_t, std::list<ST_ProcessInfo>> station_process_map_;
+    // Inverse of station_process_map_, built once on load for routing queries
+    std::unordered_map<ST_ProcessInfo, std::vector<uint32_t>> process_station_map_;
     std::unordered_map<uint8_t, Product> products_;
 };
 
@@ -4,7 +4,7 @@
 
 #include "ProductManager.h"
 #include <nlohmann/json.hpp>
-#include "LogMacros.h"
+#include "AsyncLogger.h"
 
 using nlohmann::json;
 
@@ -25,35 +25,26 @@ bool Product::GetFirstProcess(ST_ProcessInfo& out) const
     return true;
 }
 
-bool Product::GetRemainingProcesses(const Order& order, std::vector<ST_ProcessInfo>& out) const
+bool Product::GetProcessAt(const uint32_t step, ST_ProcessInfo& out) const
 {
-    out.clear();
-
-    const size_t exec_sz = order.executed_processes.size();
+    if (step >= processes.size())
+        return false;
+    out = processes[step];
+    return true;
+}
 
-    // Perfect-prefix assumption: all executed steps must equal the first exec_sz steps of processes
-    if (exec_sz > processes.size())
+bool Product::GetRemainingProcesses(const ST_OrderProgress& progress, std::vector<ST_ProcessInfo>& out) const
+{
+    out.clear();
+    if (progress.next_step == Order::off_routing)
     {
-        ERROR_MSG("[PRODUCT] Executed steps exceed defined process length.");
+        MES_LOG_ERROR("[PRODUCT] Executed steps do not match product process prefix.");
         return false;
     }
-    for (size_t i = 0; i < exec_sz; ++i)
-    {
-        if (order.executed_processes[i] != processes[i])
-        {
-            ERROR_MSG("[PRODUCT] Executed steps do not match product process prefix.");
-            return false;
-        }
-    }
-
-    // If already completed, no remaining
-    if (exec_sz == processes.size())
+    if (progress.next_step >= processes.size())
         return false;
-
-    // Push every remaining process from the current position to the end
-    for (size_t i = exec_sz; i < processes.size(); ++i)
-        out.push_back(processes[i]);
-    return !out.empty();
+    out.assign(processes.begin() + progress.next_step, processes.end());
+    return true;
 }
 
 bool Product::GetLastProcess(ST_ProcessInfo& out) const
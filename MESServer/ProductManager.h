@@ -21,7 +21,10 @@ public:
     ~Product() = default;
 
     bool GetFirstProcess(ST_ProcessInfo & out) const;
-    bool GetRemainingProcesses(const Order & order, std::vector<ST_ProcessInfo> & out) const;
+    // Process at a routing step, false past the last one or off the routing
+    bool GetProcessAt(uint32_t step, ST_ProcessInfo & out) const;
+    // Processes from the order's routing cursor to the end, false if none remain
+    bool GetRemainingProcesses(const ST_OrderProgress & progress, std::vector<ST_ProcessInfo> & out) const;
     bool GetLastProcess(ST_ProcessInfo & out) const;
 
 public:
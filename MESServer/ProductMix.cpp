@@ -0,0 +1,204 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "ProductMix.h"
+#include <algorithm>
+
+namespace {
+
+// Min-heap on the planned position, lower product types first on ties
+constexpr auto later_in_plan = [](const auto & a, const auto & b) {
+    if (a.position != b.position)
+        return a.position > b.position;
+    return a.product_type > b.product_type;
+};
+
+// Lowest set bit, the Fenwick step; ~i + 1 instead of -i, negating an unsigned is an error under MSVC /sdl
+constexpr uint32_t LowestSetBit(const uint32_t i)
+{
+    return i & (~i + 1);
+}
+
+}
+
+bool OrderReleasePolicyFromString(const std::string & s, OrderReleasePolicy & out) noexcept
+{
+    if (s == "weighted_random") out = OrderReleasePolicy::weighted_random;
+    else if (s == "round_robin") out = OrderReleasePolicy::round_robin;
+    else if (s == "heijunka") out = OrderReleasePolicy::heijunka;
+    else return false;
+    return true;
+}
+
+const char * OrderReleasePolicyToString(const OrderReleasePolicy p) noexcept
+{
+    switch (p)
+    {
+        case OrderReleasePolicy::round_robin: return "round_robin";
+        case OrderReleasePolicy::heijunka: return "heijunka";
+        default: return "weighted_random";
+    }
+}
+
+ProductMix::ProductMix(const OrderReleasePolicy policy) : policy_(policy)
+{
+}
+
+void ProductMix::Add(const uint8_t product_type, const uint32_t count)
+{
+    if (count == 0)
+        return;
+    remaining_[product_type] += count;
+    total_ += count;
+    for (uint32_t i = product_type + 1u; i <= kProductTypes; i += LowestSetBit(i))
+        tree_[i] += count;
+    if (policy_ == OrderReleasePolicy::heijunka)
+        RebuildLevelPlan();
+}
+
+bool ProductMix::Take(std::mt19937 & rng, uint8_t & out, const ProductTypeSet * admitted)
+{
+    if (total_ == 0)
+        return false;
+    const auto is_admitted = [admitted](const uint8_t type) { return admitted == nullptr || admitted->test(type); };
+
+    switch (policy_)
+    {
+        case OrderReleasePolicy::weighted_random:
+        {
+            std::uniform_int_distribution<uint32_t> distribution(1, total_);
+            out = FindByRank(distribution(rng));
+            if (!is_admitted(out) && !TakeAdmittedWeighted(rng, *admitted, out))
+                return false;
+            break;
+        }
+        case OrderReleasePolicy::round_robin:
+        {
+            // First admitted type after the cursor with a remaining target, wrapping around to the lowest one
+            uint32_t cursor = last_released_;
+            uint32_t first = kProductTypes;
+            while (true)
+            {
+                const uint32_t before = PrefixSum(cursor + 1);
+                const auto candidate = FindByRank(before < total_ ? before + 1 : 1);
+                if (is_admitted(candidate))
+                {
+                    out = candidate;
+                    break;
+                }
+                if (candidate == first)
+                    return false;
+                if (first == kProductTypes)
+                    first = candidate;
+                cursor = candidate;
+            }
+            last_released_ = out;
+            break;
+        }
+        case OrderReleasePolicy::heijunka:
+        {
+            // Entries of types not admitted are set aside and put back
+            std::vector<ST_LevelEntry> skipped;
+            bool found = false;
+            while (!found && !level_heap_.empty())
+            {
+                std::ranges::pop_heap(level_heap_, later_in_plan);
+                const auto entry = level_heap_.back();
+                level_heap_.pop_back();
+                if (is_admitted(entry.product_type))
+                {
+                    out = entry.product_type;
+                    found = true;
+                }
+                else
+                    skipped.push_back(entry);
+            }
+            for (const auto & entry : skipped)
+            {
+                level_heap_.push_back(entry);
+                std::ranges::push_heap(level_heap_, later_in_plan);
+            }
+            if (!found)
+                return false;
+            ++level_released_[out];
+            if (remaining_[out] > 1)
+                PushLevelEntry(out);
+            break;
+        }
+    }
+    Decrement(out);
+    return true;
+}
+
+uint32_t ProductMix::PrefixSum(uint32_t end_type) const
+{
+    uint32_t sum = 0;
+    for (; end_type > 0; end_type -= LowestSetBit(end_type))
+        sum += tree_[end_type];
+    return sum;
+}
+
+uint8_t ProductMix::FindByRank(uint32_t rank) const
+{
+    uint32_t position = 0;
+    for (uint32_t step = kProductTypes; step > 0; step >>= 1)
+    {
+        if (position + step <= kProductTypes && tree_[position + step] < rank)
+        {
+            position += step;
+            rank -= tree_[position];
+        }
+    }
+    return static_cast<uint8_t>(position);
+}
+
+bool ProductMix::TakeAdmittedWeighted(std::mt19937 & rng, const ProductTypeSet & admitted, uint8_t & out) const
+{
+    uint32_t admitted_total = 0;
+    for (uint32_t type = 0; type < kProductTypes; ++type)
+        admitted_total += admitted.test(type) ? remaining_[type] : 0;
+    if (admitted_total == 0)
+        return false;
+    std::uniform_int_distribution<uint32_t> distribution(1, admitted_total);
+    uint32_t pick = distribution(rng);
+    for (uint32_t type = 0; type < kProductTypes; ++type)
+    {
+        const uint32_t count = admitted.test(type) ? remaining_[type] : 0;
+        if (pick <= count)
+        {
+            out = static_cast<uint8_t>(type);
+            return true;
+        }
+        pick -= count;
+    }
+    return false;
+}
+
+void ProductMix::Decrement(const uint8_t product_type)
+{
+    --remaining_[product_type];
+    --total_;
+    for (uint32_t i = product_type + 1u; i <= kProductTypes; i += LowestSetBit(i))
+        --tree_[i];
+}
+
+void ProductMix::PushLevelEntry(const uint8_t product_type)
+{
+    // The n-th of d releases of a type ideally sits at (n + 0.5) / d of the sequence
+    level_heap_.push_back({(level_released_[product_type] + 0.5) / level_demand_[product_type], product_type});
+    std::ranges::push_heap(level_heap_, later_in_plan);
+}
+
+void ProductMix::RebuildLevelPlan()
+{
+    // New targets re-level the whole remaining mix
+    level_heap_.clear();
+    level_released_.fill(0);
+    for (uint32_t type = 0; type < kProductTypes; ++type)
+    {
+        level_demand_[type] = remaining_[type];
+        if (remaining_[type] > 0)
+            PushLevelEntry(static_cast<uint8_t>(type));
+    }
+}
@@ -0,0 +1,78 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_PRODUCTMIX_H
+#define RECONFIGMANUS_PRODUCTMIX_H
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+enum class OrderReleasePolicy : uint8_t
+{
+    weighted_random,    // product type drawn in proportion to its remaining target count
+    round_robin,        // product types with remaining targets in turn, ascending type
+    heijunka            // level mixing, the releases of each type are spread evenly over the remaining targets
+};
+
+// Product types a new order may currently be released for, see ReleaseController
+using ProductTypeSet = std::bitset<256>;
+
+// False for an unknown name, out is left unchanged
+bool OrderReleasePolicyFromString(const std::string & s, OrderReleasePolicy & out) noexcept;
+const char * OrderReleasePolicyToString(OrderReleasePolicy p) noexcept;
+
+// Remaining production targets per product type and the choice of the next type to release.
+// Counts are kept in a Fenwick tree over all 256 product types, so weighted draws, round robin
+// steps and decrements are O(log P); the heijunka plan is a binary heap, O(log P) per release.
+// Not thread-safe, OrderManager calls it under its lock.
+class ProductMix
+{
+public:
+    explicit ProductMix(OrderReleasePolicy policy = OrderReleasePolicy::weighted_random);
+
+    void Add(uint8_t product_type, uint32_t count);
+    // Picks the product type of the next order and takes one unit of its target, false if none is left.
+    // With admitted given, types outside it are skipped and the policy picks among the others.
+    bool Take(std::mt19937 & rng, uint8_t & out, const ProductTypeSet * admitted = nullptr);
+
+    [[nodiscard]] OrderReleasePolicy GetPolicy() const { return policy_; }
+    [[nodiscard]] uint32_t Total() const { return total_; }
+    [[nodiscard]] uint32_t Remaining(const uint8_t product_type) const { return remaining_[product_type]; }
+
+private:
+    static constexpr uint32_t kProductTypes = 256;
+
+    // Heijunka plan entry: position of the next release of the type within its share of the sequence
+    struct ST_LevelEntry
+    {
+        double position;
+        uint8_t product_type;
+    };
+
+    // Sum of the remaining counts of the types below end_type
+    [[nodiscard]] uint32_t PrefixSum(uint32_t end_type) const;
+    // Type holding the rank-th remaining unit in ascending type order, rank in [1, Total()]
+    [[nodiscard]] uint8_t FindByRank(uint32_t rank) const;
+    // Weighted draw restricted to the admitted types, O(P)
+    bool TakeAdmittedWeighted(std::mt19937 & rng, const ProductTypeSet & admitted, uint8_t & out) const;
+    void Decrement(uint8_t product_type);
+    void PushLevelEntry(uint8_t product_type);
+    void RebuildLevelPlan();
+
+    OrderReleasePolicy policy_;
+    std::array<uint32_t, kProductTypes> remaining_{};
+    std::array<uint32_t, kProductTypes + 1> tree_{};        // 1-based Fenwick tree of remaining_
+    uint32_t total_ = 0;
+    uint32_t last_released_ = kProductTypes - 1;            // round robin cursor
+
+    std::array<uint32_t, kProductTypes> level_released_{};  // releases since the plan was last rebuilt
+    std::array<uint32_t, kProductTypes> level_demand_{};
+    std::vector<ST_LevelEntry> level_heap_;
+};
+
+#endif //RECONFIGMANUS_PRODUCTMIX_H
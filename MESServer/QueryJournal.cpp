@@ -0,0 +1,74 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "QueryJournal.h"
+#include <cstring>
+
+namespace {
+
+constexpr char kJournalMagic[8] = "MESJRNL";
+
+}
+
+QueryJournalWriter::~QueryJournalWriter()
+{
+    Flush();
+}
+
+bool QueryJournalWriter::Open(const std::string& file, const uint64_t order_seed)
+{
+    std::lock_guard lock(mutex_);
+    file_.open(file, std::ios::binary | std::ios::trunc);
+    if (!file_.is_open())
+        return false;
+    ST_JournalHeader header{};
+    std::memcpy(header.magic, kJournalMagic, sizeof(header.magic));
+    header.version = MES_JOURNAL_VERSION;
+    header.record_size = sizeof(ST_JournalRecord);
+    header.order_seed = order_seed;
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    FlushLocked();
+    return file_.good();
+}
+
+void QueryJournalWriter::Append(const ST_JournalRecord& record)
+{
+    std::lock_guard lock(mutex_);
+    if (!file_.is_open())
+        return;
+    file_.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    if (++unflushed_records_ >= kFlushRecords ||
+        std::chrono::steady_clock::now() - last_flush_ >= std::chrono::milliseconds(kFlushIntervalMs))
+        FlushLocked();
+}
+
+void QueryJournalWriter::Flush()
+{
+    std::lock_guard lock(mutex_);
+    if (file_.is_open())
+        FlushLocked();
+}
+
+void QueryJournalWriter::FlushLocked()
+{
+    file_.flush();
+    unflushed_records_ = 0;
+    last_flush_ = std::chrono::steady_clock::now();
+}
+
+bool QueryJournalReader::Open(const std::string& file)
+{
+    file_.open(file, std::ios::binary);
+    if (!file_.is_open())
+        return false;
+    if (!file_.read(reinterpret_cast<char*>(&header_), sizeof(header_)))
+        return false;
+    return std::memcmp(header_.magic, kJournalMagic, sizeof(header_.magic)) == 0 &&
+        header_.version == MES_JOURNAL_VERSION && header_.record_size == sizeof(ST_JournalRecord);
+}
+
+bool QueryJournalReader::Next(ST_JournalRecord& out)
+{
+    return static_cast<bool>(file_.read(reinterpret_cast<char*>(&out), sizeof(out)));
+}
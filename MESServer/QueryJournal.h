@@ -0,0 +1,92 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_QUERYJOURNAL_H
+#define RECONFIGMANUS_QUERYJOURNAL_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include "mes_server_def.h"
+
+// Binary journal of station action queries and the decisions taken on them, and of the customer order
+// messages, for offline replay. Layout: one ST_JournalHeader followed by fixed-size ST_JournalRecord
+// entries in append order, native byte order. The server only journals when every message is handled on
+// the network thread, so the append order is the order the decisions were taken in.
+#define MES_JOURNAL_VERSION     2
+
+struct ST_JournalHeader
+{
+    char        magic[8];           // "MESJRNL\0"
+    uint32_t    version;
+    uint32_t    record_size;        // sizeof(ST_JournalRecord)
+    uint64_t    order_seed;         // order assignment seed of the recording MES
+};
+
+// Customer order message and its outcome
+struct ST_JournalCustomerOrder
+{
+    uint32_t    order_id;       // assigned on submit, UINT32_MAX if rejected
+    uint32_t    product_type;
+    uint32_t    priority;
+    float       due_in;
+    uint32_t    applied;        // update and cancel: 1 if the order was pending
+};
+
+struct ST_JournalRecord
+{
+    uint64_t                received_ns;    // monotonic arrival time
+    uint32_t                msg_type;       // MSG_STATION_ACTION_(DONE_)QUERY or MSG_CUSTOMER_ORDER_SUBMIT/UPDATE/CANCEL
+    uint32_t                client_id;
+    double                  now;            // MES clock the message was handled at
+    ST_StationActionQuery   qry;            // station queries
+    ST_StationActionRsp     rsp;            // decision sent back
+    ST_JournalCustomerOrder customer_order; // customer order messages
+};
+
+// Thread-safe appender, records are buffered and written in append order. The buffer is flushed every
+// kFlushRecords records and on the first append kFlushIntervalMs after the last flush, so a crash loses
+// little of the tail.
+class QueryJournalWriter
+{
+public:
+    QueryJournalWriter() = default;
+    ~QueryJournalWriter();
+
+    QueryJournalWriter(const QueryJournalWriter&) = delete;
+    QueryJournalWriter& operator=(const QueryJournalWriter&) = delete;
+
+    bool Open(const std::string& file, uint64_t order_seed);
+    void Append(const ST_JournalRecord& record);
+    void Flush();
+
+private:
+    static constexpr uint32_t kFlushRecords = 256;
+    static constexpr int64_t kFlushIntervalMs = 1000;
+
+    void FlushLocked();
+
+    std::mutex mutex_;
+    std::ofstream file_;
+    uint32_t unflushed_records_ = 0;
+    std::chrono::steady_clock::time_point last_flush_{};
+};
+
+class QueryJournalReader
+{
+public:
+    // Fails on a missing file, a bad magic or a record layout of another build
+    bool Open(const std::string& file);
+    [[nodiscard]] const ST_JournalHeader& GetHeader() const { return header_; }
+    // False at the end of the journal or on a truncated record
+    bool Next(ST_JournalRecord& out);
+
+private:
+    std::ifstream file_;
+    ST_JournalHeader header_{};
+};
+
+#endif //RECONFIGMANUS_QUERYJOURNAL_H
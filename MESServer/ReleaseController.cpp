@@ -0,0 +1,158 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "ReleaseController.h"
+#include "AsyncLogger.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Relative drop in throughput / lead time that turns the cap adaptation around, below it is noise
+constexpr double kPowerTolerance = 0.02;
+constexpr uint32_t kMinWindow = 4;
+constexpr uint32_t kMaxCapFactor = 4;
+
+}
+
+ReleaseController::ReleaseController(const bool adaptive) : adaptive_(adaptive)
+{
+}
+
+void ReleaseController::SetProcessPool(const ST_ProcessInfo process, const ST_ProcessPool& pool)
+{
+    std::lock_guard lock(mutex_);
+    pools_[process] = pool;
+}
+
+void ReleaseController::AddProduct(const uint8_t product_type, const std::vector<ST_ProcessInfo>& processes,
+    const double expected_route_time)
+{
+    std::lock_guard lock(mutex_);
+    if (processes.empty())
+        return;
+
+    // Bottleneck: the lowest service rate per visit of the route
+    std::array<uint32_t, kProcesses> visits{};
+    for (const auto process : processes)
+        ++visits[process];
+    uint32_t bottleneck = processes.front();
+    double bottleneck_rate = 0.0;
+    for (const auto process : processes)
+    {
+        const double rate = pools_[process].service_rate / visits[process];
+        if (rate > 0.0 && (bottleneck_rate == 0.0 || rate < bottleneck_rate))
+        {
+            bottleneck = process;
+            bottleneck_rate = rate;
+        }
+    }
+
+    auto & product = products_[product_type];
+    if (!product.configured)
+        product_types_.push_back(product_type);
+    product.configured = true;
+    product.first_process = processes.front();
+    product.bottleneck_process = bottleneck;
+    // Critical WIP keeps the bottleneck busy on average, its buffer absorbs the variability
+    const double critical_wip = bottleneck_rate * expected_route_time;
+    product.cap = std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(critical_wip)) + pools_[bottleneck].buffer_capacity);
+    product.max_cap = kMaxCapFactor * product.cap;
+    MES_LOG_INFO("[RELEASE] Product type {}: bottleneck process {}, critical WIP {}, WIP cap {}",
+        product_type, bottleneck, critical_wip, product.cap);
+}
+
+void ReleaseController::GetAdmittedProducts(ProductTypeSet& out) const
+{
+    std::lock_guard lock(mutex_);
+    // Products without a cap are always admitted
+    out.set();
+    const auto has_room = [this](const uint32_t process) {
+        return heading_[process] < std::max<uint32_t>(1, pools_[process].stations + pools_[process].buffer_capacity);
+    };
+    for (const auto product_type : product_types_)
+    {
+        const auto & product = products_[product_type];
+        if (product.running >= product.cap || !has_room(product.first_process) || !has_room(product.bottleneck_process))
+            out.reset(product_type);
+    }
+}
+
+void ReleaseController::OnOrderReleased(const uint32_t order_id, const uint8_t product_type, const uint32_t next_process,
+    const double now)
+{
+    std::lock_guard lock(mutex_);
+    orders_[order_id] = {product_type, next_process, now};
+    ++products_[product_type].running;
+    MoveHeading(no_process, next_process);
+}
+
+void ReleaseController::OnOrderProgress(const uint32_t order_id, const uint32_t next_process)
+{
+    std::lock_guard lock(mutex_);
+    const auto it = orders_.find(order_id);
+    if (it == orders_.end())
+        return;
+    MoveHeading(it->second.next_process, next_process);
+    it->second.next_process = next_process;
+}
+
+void ReleaseController::OnOrderFinished(const uint32_t order_id, const double now)
+{
+    std::lock_guard lock(mutex_);
+    const auto it = orders_.find(order_id);
+    if (it == orders_.end())
+        return;
+    const auto order = it->second;
+    orders_.erase(it);
+    MoveHeading(order.next_process, no_process);
+
+    auto & product = products_[order.product_type];
+    --product.running;
+    ++product.window_completions;
+    product.window_lead_time += now - order.released_at;
+    if (adaptive_ && product.configured && product.window_completions >= std::max(kMinWindow, product.cap))
+        Adapt(product, now);
+}
+
+uint32_t ReleaseController::GetProductCap(const uint8_t product_type) const
+{
+    std::lock_guard lock(mutex_);
+    return products_[product_type].cap;
+}
+
+uint32_t ReleaseController::GetRunningOrders(const uint8_t product_type) const
+{
+    std::lock_guard lock(mutex_);
+    return products_[product_type].running;
+}
+
+void ReleaseController::MoveHeading(const uint32_t from_process, const uint32_t to_process)
+{
+    if (from_process != no_process && heading_[from_process] > 0)
+        --heading_[from_process];
+    if (to_process != no_process)
+        ++heading_[to_process];
+}
+
+void ReleaseController::Adapt(ST_ProductControl& product, const double now)
+{
+    const double elapsed = now - product.window_start;
+    if (elapsed > 0.0 && product.window_lead_time > 0.0)
+    {
+        // Power: throughput over mean lead time of the window
+        const double throughput = product.window_completions / elapsed;
+        const double lead_time = product.window_lead_time / product.window_completions;
+        const double power = throughput / lead_time;
+        if (product.last_power > 0.0 && power < product.last_power * (1.0 - kPowerTolerance))
+            product.direction = -product.direction;
+        product.last_power = power;
+        product.cap = static_cast<uint32_t>(std::clamp<int64_t>(static_cast<int64_t>(product.cap) + product.direction,
+            1, product.max_cap));
+        MES_LOG_DEBUG("[RELEASE] Throughput {}, lead time {}, WIP cap now {}", throughput, lead_time, product.cap);
+    }
+    product.window_completions = 0;
+    product.window_lead_time = 0.0;
+    product.window_start = now;
+}
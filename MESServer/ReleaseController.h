@@ -0,0 +1,95 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_RELEASECONTROLLER_H
+#define RECONFIGMANUS_RELEASECONTROLLER_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "mes_server_def.h"
+#include "ProductMix.h"
+
+// Capacity of the stations able to run a process, from the graph model
+struct ST_ProcessPool
+{
+    uint32_t stations = 0;
+    double service_rate = 0.0;          // sum of 1 / mean service time over the stations
+    uint32_t buffer_capacity = 0;       // sum of buffer_capacity over the stations
+};
+
+// WIP-capped (CONWIP) order release. A new order of a product is released only while
+// - the running orders of the product are below its cap, and
+// - the orders heading for the first process and for the bottleneck process of the product (next process
+//   there, in transit, queued or in service) are below the stations plus buffer capacity of that process pool.
+// The cap of a product starts at its critical WIP, bottleneck rate times expected route time, plus the
+// bottleneck buffer. With adaptation on, each cap then moves by one after every window of completions,
+// hill climbing on throughput / lead time, which peaks where more WIP only adds queueing.
+// Product types never added have no cap and are always admitted.
+// Thread-safe; two trays released at the same time may each take the last free place.
+class ReleaseController
+{
+public:
+    static constexpr uint32_t no_process = UINT32_MAX;
+
+    explicit ReleaseController(bool adaptive);
+
+    void SetProcessPool(ST_ProcessInfo process, const ST_ProcessPool & pool);
+    // Pools of all processes of the route must be set before
+    void AddProduct(uint8_t product_type, const std::vector<ST_ProcessInfo> & processes, double expected_route_time);
+
+    // Product types a new order may be released for now
+    void GetAdmittedProducts(ProductTypeSet & out) const;
+
+    // now is the MES clock; next_process is no_process once the order has no next process
+    void OnOrderReleased(uint32_t order_id, uint8_t product_type, uint32_t next_process, double now);
+    void OnOrderProgress(uint32_t order_id, uint32_t next_process);
+    void OnOrderFinished(uint32_t order_id, double now);
+
+    [[nodiscard]] uint32_t GetProductCap(uint8_t product_type) const;
+    [[nodiscard]] uint32_t GetRunningOrders(uint8_t product_type) const;
+
+private:
+    static constexpr uint32_t kProductTypes = 256;
+    static constexpr uint32_t kProcesses = 256;
+
+    struct ST_ProductControl
+    {
+        bool configured = false;
+        uint32_t first_process = no_process;
+        uint32_t bottleneck_process = no_process;
+        uint32_t cap = 1;
+        uint32_t max_cap = 1;
+        uint32_t running = 0;
+
+        // Adaptation window
+        int32_t direction = -1;
+        uint32_t window_completions = 0;
+        double window_start = 0.0;
+        double window_lead_time = 0.0;
+        double last_power = 0.0;
+    };
+
+    struct ST_ReleasedOrder
+    {
+        uint8_t product_type;
+        uint32_t next_process;
+        double released_at;
+    };
+
+    void MoveHeading(uint32_t from_process, uint32_t to_process);
+    void Adapt(ST_ProductControl & product, double now);
+
+    const bool adaptive_;
+    mutable std::mutex mutex_;
+    std::array<ST_ProcessPool, kProcesses> pools_{};
+    std::array<uint32_t, kProcesses> heading_{};     // running orders whose next process is this one
+    std::array<ST_ProductControl, kProductTypes> products_{};
+    std::vector<uint8_t> product_types_;
+    std::unordered_map<uint32_t, ST_ReleasedOrder> orders_;
+};
+
+#endif //RECONFIGMANUS_RELEASECONTROLLER_H
@@ -0,0 +1,227 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "RoutingGraph.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+void RoutingGraph::Build(const uint32_t num_vertices, const std::vector<ST_RoutingArc>& arcs)
+{
+    num_vertices_ = num_vertices;
+
+    // Counting sort of the arcs by tail, then by head for the reverse view
+    out_offsets_.assign(num_vertices_ + 1, 0);
+    in_offsets_.assign(num_vertices_ + 1, 0);
+    for (const auto & arc : arcs)
+    {
+        ++out_offsets_[arc.tail + 1];
+        ++in_offsets_[arc.head + 1];
+    }
+    for (uint32_t v = 0; v < num_vertices_; ++v)
+    {
+        out_offsets_[v + 1] += out_offsets_[v];
+        in_offsets_[v + 1] += in_offsets_[v];
+    }
+
+    out_tails_.resize(arcs.size());
+    out_heads_.resize(arcs.size());
+    out_weights_.resize(arcs.size());
+    in_tails_.resize(arcs.size());
+    in_arcs_.resize(arcs.size());
+    std::vector<uint32_t> out_fill(out_offsets_.begin(), out_offsets_.end() - 1);
+    std::vector<uint32_t> in_fill(in_offsets_.begin(), in_offsets_.end() - 1);
+    for (const auto & arc : arcs)
+    {
+        const uint32_t slot = out_fill[arc.tail]++;
+        out_tails_[slot] = arc.tail;
+        out_heads_[slot] = arc.head;
+        // Dijkstra needs non-negative weights, guard against rounding after add/minus updates
+        out_weights_[slot] = std::max(0.0, arc.weight);
+
+        const uint32_t in_slot = in_fill[arc.head]++;
+        in_tails_[in_slot] = arc.tail;
+        in_arcs_[in_slot] = slot;
+    }
+
+    RebuildTable();
+}
+
+bool RoutingGraph::SetArcWeight(const uint32_t tail, const uint32_t head, const double weight)
+{
+    if (tail >= num_vertices_ || head >= num_vertices_)
+        return false;
+
+    for (uint32_t slot = out_offsets_[tail]; slot < out_offsets_[tail + 1]; ++slot)
+    {
+        if (out_heads_[slot] == head)
+        {
+            // Keep the weight from before the first change, repeated changes collapse into one
+            const bool queued = std::ranges::any_of(pending_changes_,
+                [slot](const auto & change) { return change.first == slot; });
+            if (!queued)
+                pending_changes_.emplace_back(slot, out_weights_[slot]);
+            out_weights_[slot] = std::max(0.0, weight);
+            return true;
+        }
+    }
+    return false;
+}
+
+void RoutingGraph::RebuildTable()
+{
+    const auto n = static_cast<size_t>(num_vertices_);
+    pending_changes_.clear();
+    dist_.assign(n * n, std::numeric_limits<double>::infinity());
+    next_.assign(n * n, npos);
+    for (uint32_t head = 0; head < num_vertices_; ++head)
+        ComputeRowToHead(head);
+}
+
+void RoutingGraph::RepairTable()
+{
+    if (pending_changes_.empty())
+        return;
+
+    // When a large share of the arcs changed, a full recomputation is cheaper than repairing
+    if (pending_changes_.size() * 4 > out_heads_.size())
+    {
+        RebuildTable();
+        return;
+    }
+
+    affected_mark_.resize(num_vertices_, 0);
+    for (uint32_t head = 0; head < num_vertices_; ++head)
+        RepairRowToHead(head);
+    pending_changes_.clear();
+}
+
+void RoutingGraph::ComputeRowToHead(const uint32_t head)
+{
+    double * dist = dist_.data() + static_cast<size_t>(head) * num_vertices_;
+    uint32_t * next = next_.data() + static_cast<size_t>(head) * num_vertices_;
+
+    heap_.clear();
+    dist[head] = 0.0;
+    next[head] = head;
+    heap_.emplace_back(0.0, head);
+    PropagateRow(dist, next);
+}
+
+void RoutingGraph::RepairRowToHead(const uint32_t head)
+{
+    double * dist = dist_.data() + static_cast<size_t>(head) * num_vertices_;
+    uint32_t * next = next_.data() + static_cast<size_t>(head) * num_vertices_;
+    constexpr auto cmp = std::greater<>{};
+
+    // Fresh epoch so the affected marks need no clearing between rows
+    if (++affected_epoch_ == 0)
+    {
+        std::ranges::fill(affected_mark_, 0);
+        affected_epoch_ = 1;
+    }
+    affected_.clear();
+
+    // 1. Increased tree arcs: every vertex whose first-hop chain runs through such an arc loses its distance
+    for (const auto & [slot, old_weight] : pending_changes_)
+    {
+        if (out_weights_[slot] <= old_weight)
+            continue;
+        const uint32_t x = out_heads_[slot];
+        const uint32_t u = out_tails_[slot];
+        if (u == head || next[u] != x || affected_mark_[u] == affected_epoch_)
+            continue;
+
+        // Walk the first-hop tree backwards from u, the list doubles as the BFS queue
+        affected_mark_[u] = affected_epoch_;
+        const size_t first = affected_.size();
+        affected_.push_back(u);
+        for (size_t i = first; i < affected_.size(); ++i)
+        {
+            const uint32_t y = affected_[i];
+            for (uint32_t k = in_offsets_[y]; k < in_offsets_[y + 1]; ++k)
+            {
+                const uint32_t p = in_tails_[k];
+                if (next[p] == y && affected_mark_[p] != affected_epoch_)
+                {
+                    affected_mark_[p] = affected_epoch_;
+                    affected_.push_back(p);
+                }
+            }
+        }
+    }
+
+    // 2. Seed the affected vertices with their best arc into the unaffected part of the tree
+    heap_.clear();
+    for (const uint32_t v : affected_)
+    {
+        dist[v] = std::numeric_limits<double>::infinity();
+        next[v] = npos;
+    }
+    for (const uint32_t v : affected_)
+    {
+        for (uint32_t slot = out_offsets_[v]; slot < out_offsets_[v + 1]; ++slot)
+        {
+            const uint32_t y = out_heads_[slot];
+            if (affected_mark_[y] == affected_epoch_)
+                continue;
+            const double nd = dist[y] + out_weights_[slot];
+            if (nd < dist[v])
+            {
+                dist[v] = nd;
+                next[v] = y;
+            }
+        }
+        if (std::isfinite(dist[v]))
+            heap_.emplace_back(dist[v], v);
+    }
+
+    // 3. Decreased arcs can only shorten the distance of their own tail
+    for (const auto & [slot, old_weight] : pending_changes_)
+    {
+        if (out_weights_[slot] >= old_weight)
+            continue;
+        const uint32_t x = out_heads_[slot];
+        const uint32_t u = out_tails_[slot];
+        const double nd = dist[x] + out_weights_[slot];
+        if (nd < dist[u])
+        {
+            dist[u] = nd;
+            next[u] = x;
+            heap_.emplace_back(nd, u);
+        }
+    }
+
+    // 4. Propagate the new distances backwards from the seeds
+    std::ranges::make_heap(heap_, cmp);
+    PropagateRow(dist, next);
+}
+
+void RoutingGraph::PropagateRow(double * dist, uint32_t * next)
+{
+    // Min-heap with lazy deletion, stale entries are skipped when popped
+    constexpr auto cmp = std::greater<>{};
+    while (!heap_.empty())
+    {
+        std::pop_heap(heap_.begin(), heap_.end(), cmp);
+        const auto [d, v] = heap_.back();
+        heap_.pop_back();
+        if (d > dist[v])
+            continue;
+
+        // Relax every arc (u -> v): going through v is a candidate first hop for u
+        for (uint32_t i = in_offsets_[v]; i < in_offsets_[v + 1]; ++i)
+        {
+            const uint32_t u = in_tails_[i];
+            const double nd = d + out_weights_[in_arcs_[i]];
+            if (nd < dist[u])
+            {
+                dist[u] = nd;
+                next[u] = v;
+                heap_.emplace_back(nd, u);
+                std::push_heap(heap_.begin(), heap_.end(), cmp);
+            }
+        }
+    }
+}
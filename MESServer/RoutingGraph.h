@@ -0,0 +1,81 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_ROUTINGGRAPH_H
+#define RECONFIGMANUS_ROUTINGGRAPH_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+struct ST_RoutingArc
+{
+    uint32_t tail{};    // dense vertex index
+    uint32_t head{};    // dense vertex index
+    double weight{};    // expected transfer time
+};
+
+// Read-only compressed-sparse-row snapshot of the production graph used for routing.
+// Only the hot data lives here: contiguous adjacency arrays and precomputed arc weights.
+// Names and time distributions stay in the labelled graph held by GraphManager.
+// Vertices are addressed by dense index (the vertex descriptor of the labelled graph).
+class RoutingGraph
+{
+public:
+    static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
+
+    RoutingGraph() = default;
+    ~RoutingGraph() = default;
+
+    // Regenerate the snapshot from an arc list and recompute the all-pairs table
+    void Build(uint32_t num_vertices, const std::vector<ST_RoutingArc>& arcs);
+    // Patch the cached weight of arc (tail, head), returns false if the arc does not exist.
+    // The change is queued until the next RepairTable() or RebuildTable().
+    bool SetArcWeight(uint32_t tail, uint32_t head, double weight);
+    // Recompute the all-pairs distance and next-hop table from the cached weights
+    void RebuildTable();
+    // Apply the queued arc weight changes, repairing only the affected part of the table
+    void RepairTable();
+
+    [[nodiscard]] uint32_t NumVertices() const { return num_vertices_; }
+    [[nodiscard]] double Distance(uint32_t tail, uint32_t head) const { return dist_[head * num_vertices_ + tail]; }
+    [[nodiscard]] uint32_t NextHop(uint32_t tail, uint32_t head) const { return next_[head * num_vertices_ + tail]; }
+
+private:
+    // Dijkstra towards head over incoming arcs, filling the table row of head
+    void ComputeRowToHead(uint32_t head);
+    // Ramalingam-Reps style repair of the table row of head after the queued arc changes
+    void RepairRowToHead(uint32_t head);
+    // Settle the heap entries into the row of head, propagating over incoming arcs
+    void PropagateRow(double * dist, uint32_t * next);
+
+    uint32_t num_vertices_ = 0;
+
+    // Outgoing arcs: out_heads_[out_offsets_[v] .. out_offsets_[v + 1]], out_tails_ maps a slot back to v
+    std::vector<uint32_t> out_offsets_;
+    std::vector<uint32_t> out_tails_;
+    std::vector<uint32_t> out_heads_;
+    std::vector<double> out_weights_;
+
+    // Incoming arcs: in_tails_[in_offsets_[v] .. in_offsets_[v + 1]], in_arcs_ points into out_weights_
+    std::vector<uint32_t> in_offsets_;
+    std::vector<uint32_t> in_tails_;
+    std::vector<uint32_t> in_arcs_;
+
+    // All-pairs table, head-major [head * n + tail] so each Dijkstra run writes one contiguous row.
+    // next_ holds the first hop from tail towards head (== head when tail == head, npos when unreachable).
+    std::vector<double> dist_;
+    std::vector<uint32_t> next_;
+
+    // Arc weight changes not yet applied to the table: out-arc slot and weight before the change
+    std::vector<std::pair<uint32_t, double>> pending_changes_;
+
+    // Scratch buffers reused across Dijkstra runs and repairs
+    std::vector<std::pair<double, uint32_t>> heap_;
+    std::vector<uint32_t> affected_;
+    std::vector<uint32_t> affected_mark_;
+    uint32_t affected_epoch_ = 0;
+};
+
+#endif //RECONFIGMANUS_ROUTINGGRAPH_H
@@ -0,0 +1,62 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "ShardedExecutor.h"
+#include <algorithm>
+
+ShardedExecutor::ShardedExecutor(size_t num_shards)
+{
+    num_shards = std::max<size_t>(1, num_shards);
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i)
+    {
+        auto shard = std::make_unique<Shard>();
+        shard->worker = std::thread(WorkerLoop, std::ref(*shard));
+        shards_.push_back(std::move(shard));
+    }
+}
+
+ShardedExecutor::~ShardedExecutor()
+{
+    // Remaining tasks are drained before the workers exit
+    for (auto & shard : shards_)
+    {
+        {
+            std::lock_guard lock(shard->mutex);
+            shard->stopping = true;
+        }
+        shard->cv.notify_one();
+    }
+    for (auto & shard : shards_)
+        shard->worker.join();
+}
+
+void ShardedExecutor::Post(const uint32_t shard_key, std::function<void()> task)
+{
+    auto & shard = *shards_[shard_key % shards_.size()];
+    {
+        std::lock_guard lock(shard.mutex);
+        shard.tasks.push_back(std::move(task));
+    }
+    shard.cv.notify_one();
+}
+
+void ShardedExecutor::WorkerLoop(Shard& shard)
+{
+    std::deque<std::function<void()>> batch;
+    while (true)
+    {
+        {
+            std::unique_lock lock(shard.mutex);
+            shard.cv.wait(lock, [&shard] { return shard.stopping || !shard.tasks.empty(); });
+            if (shard.stopping && shard.tasks.empty())
+                return;
+            // Take everything queued at once to keep the lock hold short
+            batch.swap(shard.tasks);
+        }
+        for (auto & task : batch)
+            task();
+        batch.clear();
+    }
+}
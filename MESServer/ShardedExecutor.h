@@ -0,0 +1,47 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_SHARDEDEXECUTOR_H
+#define RECONFIGMANUS_SHARDEDEXECUTOR_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Worker pool where every task carries a shard key. Tasks with the same key always run on the
+// same worker in submission order, tasks with different keys may run concurrently.
+class ShardedExecutor
+{
+public:
+    explicit ShardedExecutor(size_t num_shards);
+    ~ShardedExecutor();
+
+    ShardedExecutor(const ShardedExecutor&) = delete;
+    ShardedExecutor& operator=(const ShardedExecutor&) = delete;
+
+    void Post(uint32_t shard_key, std::function<void()> task);
+
+    [[nodiscard]] size_t NumShards() const { return shards_.size(); }
+
+private:
+    struct Shard
+    {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stopping = false;
+        std::thread worker;
+    };
+
+    static void WorkerLoop(Shard & shard);
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+#endif //RECONFIGMANUS_SHARDEDEXECUTOR_H
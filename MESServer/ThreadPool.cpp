@@ -0,0 +1,74 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <latch>
+
+ThreadPool::ThreadPool(size_t num_threads)
+{
+    if (num_threads == 0)
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    workers_.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i)
+        workers_.emplace_back([this] { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto & worker : workers_)
+        worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::ParallelFor(const size_t count, const std::function<void(size_t)>& fn)
+{
+    if (count == 0)
+        return;
+
+    // Indices are claimed dynamically so uneven tasks balance out, the caller helps as well
+    std::atomic<size_t> next_index{0};
+    auto drain = [&] {
+        for (size_t i = next_index.fetch_add(1); i < count; i = next_index.fetch_add(1))
+            fn(i);
+    };
+
+    const size_t helpers = std::min(workers_.size(), count - 1);
+    std::latch done(static_cast<std::ptrdiff_t>(helpers));
+    for (size_t h = 0; h < helpers; ++h)
+        Submit([&] { drain(); done.count_down(); });
+    drain();
+    done.wait();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (stopping_ && tasks_.empty())
+                return;
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
@@ -0,0 +1,43 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_THREADPOOL_H
+#define RECONFIGMANUS_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed-size worker pool with a shared FIFO task queue
+class ThreadPool
+{
+public:
+    // 0 threads picks the hardware concurrency
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void Submit(std::function<void()> task);
+    // Run fn(i) for every i in [0, count) across the pool and the calling thread, returns when all are done
+    void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    [[nodiscard]] size_t NumThreads() const { return workers_.size(); }
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+#endif //RECONFIGMANUS_THREADPOOL_H
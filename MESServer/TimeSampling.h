@@ -0,0 +1,179 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_TIMESAMPLING_H
+#define RECONFIGMANUS_TIMESAMPLING_H
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <span>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// Each (seed, stream) pair is an independent sequence, block i of it is a pure function of
+// (seed, stream, i), so streams can be handed to threads or tasks without any shared state.
+class PhiloxEngine
+{
+public:
+    using result_type = uint32_t;
+
+    PhiloxEngine() : PhiloxEngine(0, 0) {}
+    PhiloxEngine(uint64_t seed, uint64_t stream)
+        : key_{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)},
+          stream_{static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)} {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        if (buffered_ == 0)
+        {
+            block_ = Generate(counter_++);
+            buffered_ = 4;
+        }
+        return block_[--buffered_];
+    }
+
+    // Fill out with uniform doubles in the open interval (0, 1), four per generator block
+    void FillUniform(std::span<double> out)
+    {
+        constexpr double scale = 1.0 / 4294967296.0; // 2^-32
+        size_t i = 0;
+        for (; buffered_ > 0 && i < out.size(); ++i)
+            out[i] = (static_cast<double>(block_[--buffered_]) + 0.5) * scale;
+        for (; i + 4 <= out.size(); i += 4)
+        {
+            const auto block = Generate(counter_++);
+            for (size_t j = 0; j < 4; ++j)
+                out[i + j] = (static_cast<double>(block[j]) + 0.5) * scale;
+        }
+        for (; i < out.size(); ++i)
+            out[i] = (static_cast<double>((*this)()) + 0.5) * scale;
+    }
+
+private:
+    [[nodiscard]] std::array<uint32_t, 4> Generate(uint64_t counter) const
+    {
+        std::array<uint32_t, 4> c{static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32),
+            stream_[0], stream_[1]};
+        std::array<uint32_t, 2> k = key_;
+        for (int round = 0; round < 10; ++round)
+        {
+            const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c[0];
+            const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c[2];
+            c = {static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k[0], static_cast<uint32_t>(p1),
+                 static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k[1], static_cast<uint32_t>(p0)};
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        return c;
+    }
+
+    std::array<uint32_t, 2> key_;
+    std::array<uint32_t, 2> stream_;
+    uint64_t counter_ = 0;
+    std::array<uint32_t, 4> block_{};
+    uint32_t buffered_ = 0;
+};
+
+// Process-wide sampling seed. Every thread draws from its own stream of this seed;
+// changing the seed restarts all thread streams on their next draw.
+inline std::atomic<uint64_t> g_sampling_seed{0x5EED5EED5EED5EEDull};
+inline std::atomic<uint64_t> g_sampling_seed_epoch{0};
+inline std::atomic<uint64_t> g_sampling_next_stream{0};
+
+inline void SetSamplingSeed(uint64_t seed)
+{
+    g_sampling_seed.store(seed, std::memory_order_relaxed);
+    g_sampling_next_stream.store(0, std::memory_order_relaxed);
+    g_sampling_seed_epoch.fetch_add(1, std::memory_order_release);
+}
+
+inline PhiloxEngine & ThreadSamplingStream()
+{
+    thread_local PhiloxEngine engine;
+    thread_local uint64_t epoch = UINT64_MAX;
+    if (const auto cur = g_sampling_seed_epoch.load(std::memory_order_acquire); cur != epoch)
+    {
+        epoch = cur;
+        engine = PhiloxEngine(g_sampling_seed.load(std::memory_order_relaxed),
+            g_sampling_next_stream.fetch_add(1, std::memory_order_relaxed));
+    }
+    return engine;
+}
+
+// Batch sampling kernels: uniforms are generated into out first, then transformed in place with
+// straight loops over contiguous memory, so the compiler can vectorize the transforms.
+// Invalid parameters yield zeros, and every sample is clamped to be non-negative.
+namespace TimeSampling
+{
+    inline void ClampNonNegative(std::span<double> out)
+    {
+        for (auto & x : out)
+            x = x > 0 ? x : 0.0;
+    }
+
+    inline void Uniform(double a, double b, std::span<double> out, PhiloxEngine & rng)
+    {
+        rng.FillUniform(out);
+        const double width = b - a;
+        for (auto & x : out)
+            x = a + width * x;
+        ClampNonNegative(out);
+    }
+
+    inline void Normal(double mu, double sigma, std::span<double> out, PhiloxEngine & rng)
+    {
+        // Box-Muller on pairs (u1, u2), the odd tail sample draws a fresh pair
+        rng.FillUniform(out);
+        const size_t pairs = out.size() / 2;
+        for (size_t i = 0; i < pairs; ++i)
+        {
+            const double r = std::sqrt(-2.0 * std::log(out[2 * i]));
+            const double theta = 2.0 * std::numbers::pi * out[2 * i + 1];
+            out[2 * i] = mu + sigma * r * std::cos(theta);
+            out[2 * i + 1] = mu + sigma * r * std::sin(theta);
+        }
+        if (out.size() % 2 != 0)
+        {
+            double u[2];
+            rng.FillUniform(u);
+            out.back() = mu + sigma * std::sqrt(-2.0 * std::log(u[0])) * std::cos(2.0 * std::numbers::pi * u[1]);
+        }
+        ClampNonNegative(out);
+    }
+
+    inline void Exponential(double lambda, std::span<double> out, PhiloxEngine & rng)
+    {
+        rng.FillUniform(out);
+        const double inv_lambda = 1.0 / lambda;
+        for (auto & x : out)
+            x = -std::log(x) * inv_lambda;
+    }
+
+    inline void Triangular(double a, double b, double c, std::span<double> out, PhiloxEngine & rng)
+    {
+        rng.FillUniform(out);
+        const double fc = (c - a) / (b - a);
+        const double left = (b - a) * (c - a);
+        const double right = (b - a) * (b - c);
+        for (auto & u : out)
+            u = u < fc ? a + std::sqrt(u * left) : b - std::sqrt((1.0 - u) * right);
+        ClampNonNegative(out);
+    }
+
+    inline void Weibull(double k, double lambda, std::span<double> out, PhiloxEngine & rng)
+    {
+        rng.FillUniform(out);
+        const double inv_k = 1.0 / k;
+        for (auto & x : out)
+            x = lambda * std::pow(-std::log(x), inv_k);
+    }
+}
+
+#endif //RECONFIGMANUS_TIMESAMPLING_H
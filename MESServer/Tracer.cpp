@@ -0,0 +1,187 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "Tracer.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace MESTrace
+{
+    namespace
+    {
+        const char * DecisionName(const EventType type)
+        {
+            switch (type)
+            {
+                case EventType::decision_execute: return "execute";
+                case EventType::decision_route: return "route";
+                case EventType::decision_reroute: return "reroute";
+                default: return "default release";
+            }
+        }
+    }
+
+    Tracer& Tracer::Instance()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    void Tracer::Enable(const uint32_t capacity)
+    {
+        static std::once_flag once;
+        if (capacity == 0)
+            return;
+        std::call_once(once, [this, capacity] {
+            const auto size = std::bit_ceil(static_cast<uint64_t>(capacity));
+            slots_ = std::make_unique<Slot[]>(size);
+            mask_ = size - 1;
+            enabled_.store(true, std::memory_order_release);
+        });
+    }
+
+    void Tracer::Record(const EventType type, const uint32_t tray_id, const uint32_t order_id, const uint32_t station_id,
+        const uint32_t arg) noexcept
+    {
+        if (!IsEnabled())
+            return;
+        const auto position = head_.fetch_add(1, std::memory_order_relaxed);
+        auto & slot = slots_[position & mask_];
+        slot.seq.store(2 * position + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timestamp_ns.store(MESMetrics::NowNs(), std::memory_order_relaxed);
+        slot.ids.store(static_cast<uint64_t>(tray_id) << 32 | order_id, std::memory_order_relaxed);
+        slot.detail.store(static_cast<uint64_t>(station_id) << 32 | arg, std::memory_order_relaxed);
+        slot.type.store(static_cast<uint16_t>(type), std::memory_order_relaxed);
+        slot.seq.store(2 * position + 2, std::memory_order_release);
+    }
+
+    size_t Tracer::DumpChromeTrace(std::ostream& os) const
+    {
+        std::vector<ST_TraceEvent> events;
+        Snapshot(events);
+        return WriteChromeTrace(os, std::move(events));
+    }
+
+    void Tracer::Snapshot(std::vector<ST_TraceEvent>& events) const
+    {
+        events.clear();
+        if (IsEnabled())
+        {
+            const auto head = head_.load(std::memory_order_acquire);
+            const auto capacity = mask_ + 1;
+            events.reserve(std::min(head, capacity));
+            for (auto position = head > capacity ? head - capacity : 0; position < head; ++position)
+            {
+                const auto & slot = slots_[position & mask_];
+                const auto seq = slot.seq.load(std::memory_order_acquire);
+                const auto timestamp_ns = slot.timestamp_ns.load(std::memory_order_relaxed);
+                const auto ids = slot.ids.load(std::memory_order_relaxed);
+                const auto detail = slot.detail.load(std::memory_order_relaxed);
+                const auto type = slot.type.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                // Still being written, or already overwritten by a later lap
+                if (seq != 2 * position + 2 || slot.seq.load(std::memory_order_relaxed) != seq)
+                    continue;
+                events.push_back({timestamp_ns, static_cast<uint32_t>(ids >> 32), static_cast<uint32_t>(ids),
+                    static_cast<uint32_t>(detail >> 32), static_cast<EventType>(type), static_cast<uint32_t>(detail)});
+            }
+        }
+    }
+
+    size_t Tracer::WriteChromeTrace(std::ostream& os, std::vector<ST_TraceEvent> events)
+    {
+        // Writers on different threads may claim slots slightly out of time order
+        std::ranges::stable_sort(events, {}, &ST_TraceEvent::timestamp_ns);
+
+        const uint64_t origin = events.empty() ? 0 : events.front().timestamp_ns;
+        const auto us = [](const uint64_t ns) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.3f", static_cast<double>(ns) / 1000.0);
+            return std::string(buf);
+        };
+        bool first = true;
+        const auto emit = [&os, &first](const std::string & event) {
+            os << (first ? "\n" : ",\n") << event;
+            first = false;
+        };
+
+        // Trays are threads of process 1, orders are async spans of process 2
+        os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        emit(R"({"ph":"M","pid":1,"name":"process_name","args":{"name":"Trays"}})");
+        emit(R"({"ph":"M","pid":2,"name":"process_name","args":{"name":"Orders"}})");
+
+        struct ST_OpenSpan
+        {
+            uint64_t start_ns;
+            uint32_t station_id;
+            uint32_t arg;
+        };
+        std::unordered_set<uint32_t> named_trays;
+        std::unordered_map<uint32_t, ST_OpenSpan> transits;     // by tray, from release to the next query
+        std::unordered_map<uint32_t, ST_OpenSpan> processes;    // by tray, from process start to done
+        for (const auto & e : events)
+        {
+            const auto tray = std::to_string(e.tray_id);
+            const auto station = std::to_string(e.station_id);
+            const auto order = std::to_string(e.order_id);
+            if (named_trays.insert(e.tray_id).second)
+                emit(R"({"ph":"M","pid":1,"tid":)" + tray + R"(,"name":"thread_name","args":{"name":"Tray )" + tray + "\"}}");
+            const auto lane = R"("pid":1,"tid":)" + tray;
+            switch (e.type)
+            {
+                case EventType::query_received:
+                case EventType::done_query_received:
+                    if (const auto it = transits.find(e.tray_id); it != transits.end())
+                    {
+                        emit(R"({"ph":"X","name":"transit",)" + lane + R"(,"ts":)" + us(it->second.start_ns - origin) +
+                            R"(,"dur":)" + us(e.timestamp_ns - it->second.start_ns) + R"(,"args":{"from":)" +
+                            std::to_string(it->second.station_id) + R"(,"to":)" + station + "}}");
+                        transits.erase(it);
+                    }
+                    emit(R"({"ph":"i","s":"t","name":")" + std::string(e.type == EventType::query_received ? "query" : "done query") +
+                        "\"," + lane + R"(,"ts":)" + us(e.timestamp_ns - origin) + R"(,"args":{"station":)" + station + "}}");
+                    break;
+                case EventType::decision_execute:
+                case EventType::decision_route:
+                case EventType::decision_reroute:
+                case EventType::decision_default_release:
+                    emit(R"({"ph":"i","s":"t","name":")" + std::string(DecisionName(e.type)) + "\"," + lane +
+                        R"(,"ts":)" + us(e.timestamp_ns - origin) + R"(,"args":{"station":)" + station + R"(,"order":)" + order +
+                        R"(,"next_station":)" + std::to_string(e.arg) + "}}");
+                    if (e.type != EventType::decision_execute)
+                        transits[e.tray_id] = {e.timestamp_ns, e.station_id, 0};
+                    break;
+                case EventType::process_start:
+                    processes[e.tray_id] = {e.timestamp_ns, e.station_id, e.arg};
+                    break;
+                case EventType::process_done:
+                    if (const auto it = processes.find(e.tray_id); it != processes.end())
+                    {
+                        emit(R"({"ph":"X","name":"process )" + std::to_string(it->second.arg) + "\"," + lane +
+                            R"(,"ts":)" + us(it->second.start_ns - origin) + R"(,"dur":)" +
+                            us(e.timestamp_ns - it->second.start_ns) + R"(,"args":{"station":)" + station +
+                            R"(,"order":)" + order + "}}");
+                        processes.erase(it);
+                    }
+                    break;
+                case EventType::order_assigned:
+                case EventType::order_finished:
+                    emit(R"({"ph":")" + std::string(e.type == EventType::order_assigned ? "b" : "e") +
+                        R"(","cat":"order","name":"order )" + order + R"(","id":)" + order + R"(,"pid":2,"ts":)" +
+                        us(e.timestamp_ns - origin) + R"(,"args":{"tray":)" + tray + R"(,"station":)" + station + "}}");
+                    break;
+            }
+        }
+        os << "\n]}\n";
+        return events.size();
+    }
+}
@@ -0,0 +1,86 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_TRACER_H
+#define RECONFIGMANUS_TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace MESTrace
+{
+    enum class EventType : uint16_t
+    {
+        query_received,             // station action query, tray at station
+        done_query_received,        // station action done query
+        decision_execute,           // decisions carry the next station as arg
+        decision_route,             // released towards the station of its next process
+        decision_reroute,           // released towards a different process station than before
+        decision_default_release,
+        order_assigned,
+        order_finished,
+        process_start,              // arg is the process
+        process_done,               // arg is the process
+    };
+
+    struct ST_TraceEvent
+    {
+        uint64_t timestamp_ns;
+        uint32_t tray_id;
+        uint32_t order_id;
+        uint32_t station_id;
+        EventType type;
+        uint32_t arg;
+    };
+
+    // Process-wide event tracer. Events are packed into a fixed ring of binary records that overwrites the
+    // oldest ones, writers claim a slot with one atomic add and never block. Disabled until Enable is called.
+    class Tracer
+    {
+    public:
+        static Tracer& Instance();
+
+        // Allocates a ring of at least capacity events, the first call wins
+        void Enable(uint32_t capacity);
+        bool IsEnabled() const noexcept { return enabled_.load(std::memory_order_acquire); }
+
+        void Record(EventType type, uint32_t tray_id, uint32_t order_id, uint32_t station_id, uint32_t arg = 0) noexcept;
+
+        // Writes the events still in the ring as Chrome/Perfetto trace JSON, one lane per tray, and returns
+        // their number. Safe while writers are running, slots overwritten during the dump are skipped.
+        size_t DumpChromeTrace(std::ostream& os) const;
+        // The two halves of DumpChromeTrace: copying the events out of the ring is cheap, sorting and
+        // formatting them can be left to another thread
+        void Snapshot(std::vector<ST_TraceEvent>& events) const;
+        static size_t WriteChromeTrace(std::ostream& os, std::vector<ST_TraceEvent> events);
+
+    private:
+        Tracer() = default;
+
+        // Sequence-locked slot: seq is odd while the slot is written, 2 * position + 2 once it holds the
+        // event written at that ring position
+        struct Slot
+        {
+            std::atomic<uint64_t> seq{0};
+            std::atomic<uint64_t> timestamp_ns{0};
+            std::atomic<uint64_t> ids{0};           // tray_id << 32 | order_id
+            std::atomic<uint64_t> detail{0};        // station_id << 32 | arg
+            std::atomic<uint16_t> type{0};
+        };
+
+        std::atomic<bool> enabled_{false};
+        std::unique_ptr<Slot[]> slots_;
+        uint64_t mask_ = 0;
+        alignas(64) std::atomic<uint64_t> head_{0};
+    };
+}
+
+#define MES_TRACE(type, tray_id, order_id, station_id, ...) \
+    do { auto & mes_tracer = MESTrace::Tracer::Instance(); \
+         if (mes_tracer.IsEnabled()) mes_tracer.Record(MESTrace::EventType::type, tray_id, order_id, station_id, ##__VA_ARGS__); } while (0)
+
+#endif //RECONFIGMANUS_TRACER_H
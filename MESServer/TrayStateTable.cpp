@@ -0,0 +1,73 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "TrayStateTable.h"
+#include <algorithm>
+#include <bit>
+
+TrayStateTable::TrayStateTable(const uint32_t capacity)
+    : capacity_(std::max<uint32_t>(1, capacity))
+    , bucket_mask_(std::bit_ceil(capacity_ * 2) - 1)
+    , bucket_keys_(bucket_mask_ + 1)
+    , bucket_slots_(bucket_mask_ + 1)
+    , tray_ids_(capacity_, npos)
+    , order_ids_(capacity_, npos)
+    , station_ids_(capacity_)
+    , arrival_times_(capacity_, 0)
+    , route_states_(capacity_, TrayRouteState::in_transit)
+    , route_targets_(capacity_, npos)
+{
+    for (auto & key : bucket_keys_)
+        key.store(kEmptyKey, std::memory_order_relaxed);
+    for (auto & slot : bucket_slots_)
+        slot.store(npos, std::memory_order_relaxed);
+    for (auto & station : station_ids_)
+        station.store(npos, std::memory_order_relaxed);
+}
+
+uint32_t TrayStateTable::Acquire(const uint32_t tray_id)
+{
+    if (tray_id == kEmptyKey)
+        return npos;
+    // The table is at most half full, so probing always ends at the key or an empty bucket
+    for (uint32_t b = Bucket(tray_id);; b = (b + 1) & bucket_mask_)
+    {
+        auto key = bucket_keys_[b].load(std::memory_order_acquire);
+        if (key == kEmptyKey)
+        {
+            // Stop claiming buckets once the slots run out, so unknown IDs cannot fill the index
+            if (next_slot_.load(std::memory_order_acquire) >= capacity_)
+                return npos;
+            if (!bucket_keys_[b].compare_exchange_strong(key, tray_id, std::memory_order_acq_rel))
+            {
+                // Another tray took the bucket, unless it was this one
+                if (key != tray_id)
+                    continue;
+                return bucket_slots_[b].load(std::memory_order_acquire);
+            }
+            const auto slot = next_slot_.fetch_add(1, std::memory_order_acq_rel);
+            if (slot >= capacity_)
+                return npos;    // the bucket keeps the ID without a slot, so the tray is rejected for good
+            tray_ids_[slot] = tray_id;
+            bucket_slots_[b].store(slot, std::memory_order_release);
+            return slot;
+        }
+        if (key == tray_id)
+            return bucket_slots_[b].load(std::memory_order_acquire);
+    }
+}
+
+uint32_t TrayStateTable::Find(const uint32_t tray_id) const
+{
+    if (tray_id == kEmptyKey)
+        return npos;
+    for (uint32_t b = Bucket(tray_id);; b = (b + 1) & bucket_mask_)
+    {
+        const auto key = bucket_keys_[b].load(std::memory_order_acquire);
+        if (key == kEmptyKey)
+            return npos;
+        if (key == tray_id)
+            return bucket_slots_[b].load(std::memory_order_acquire);
+    }
+}
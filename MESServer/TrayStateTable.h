@@ -0,0 +1,82 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#ifndef RECONFIGMANUS_TRAYSTATETABLE_H
+#define RECONFIGMANUS_TRAYSTATETABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum class TrayRouteState : uint8_t
+{
+    at_station,     // queried at its current station, waiting for a decision
+    processing,     // executing a process at its current station
+    in_transit      // released towards its current station
+};
+
+// Per-tray MES state in struct-of-arrays layout with a fixed capacity. A tray ID is resolved to a
+// dense slot once per message, all further accesses index the arrays directly.
+// Thread-safety: slot resolution is lock-free. The fields of a slot are written only by the thread
+// handling that tray's messages; the current station may also be read from other threads.
+class TrayStateTable
+{
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    explicit TrayStateTable(uint32_t capacity);
+
+    // Slot of the tray, a fresh one is allocated on first sight. npos if the table is full.
+    uint32_t Acquire(uint32_t tray_id);
+    // Slot of a known tray, npos otherwise
+    [[nodiscard]] uint32_t Find(uint32_t tray_id) const;
+
+    [[nodiscard]] uint32_t Capacity() const { return capacity_; }
+    [[nodiscard]] uint32_t Size() const { return std::min(next_slot_.load(std::memory_order_acquire), capacity_); }
+
+    [[nodiscard]] uint32_t GetTrayId(const uint32_t slot) const { return tray_ids_[slot]; }
+
+    // Executing order, npos if the tray carries none
+    [[nodiscard]] uint32_t GetOrderId(const uint32_t slot) const { return order_ids_[slot]; }
+    [[nodiscard]] bool IsExecutingOrder(const uint32_t slot) const { return order_ids_[slot] != npos; }
+    void SetOrderId(const uint32_t slot, const uint32_t order_id) { order_ids_[slot] = order_id; }
+
+    // Station the tray is at or has been released to, npos before its first query
+    [[nodiscard]] uint32_t GetStation(const uint32_t slot) const { return station_ids_[slot].load(std::memory_order_relaxed); }
+    void SetStation(const uint32_t slot, const uint32_t station_id) { station_ids_[slot].store(station_id, std::memory_order_relaxed); }
+
+    // Steady clock time of the arrival at the current station, in nanoseconds
+    [[nodiscard]] uint64_t GetArrivalTime(const uint32_t slot) const { return arrival_times_[slot]; }
+    void SetArrivalTime(const uint32_t slot, const uint64_t time_ns) { arrival_times_[slot] = time_ns; }
+
+    [[nodiscard]] TrayRouteState GetRouteState(const uint32_t slot) const { return route_states_[slot]; }
+    void SetRouteState(const uint32_t slot, const TrayRouteState state) { route_states_[slot] = state; }
+
+    // Station the tray is routed to for its next process, npos if released without a target
+    [[nodiscard]] uint32_t GetRouteTarget(const uint32_t slot) const { return route_targets_[slot]; }
+    void SetRouteTarget(const uint32_t slot, const uint32_t station_id) { route_targets_[slot] = station_id; }
+
+private:
+    static constexpr uint32_t kEmptyKey = UINT32_MAX;
+
+    [[nodiscard]] uint32_t Bucket(const uint32_t tray_id) const { return (tray_id * 0x9E3779B1u) & bucket_mask_; }
+
+    uint32_t capacity_;
+
+    // Open-addressing ID -> slot index, twice the capacity rounded up to a power of two
+    uint32_t bucket_mask_;
+    std::vector<std::atomic<uint32_t>> bucket_keys_;
+    std::vector<std::atomic<uint32_t>> bucket_slots_;
+    std::atomic<uint32_t> next_slot_{0};
+
+    std::vector<uint32_t> tray_ids_;
+    std::vector<uint32_t> order_ids_;
+    std::vector<std::atomic<uint32_t>> station_ids_;
+    std::vector<uint64_t> arrival_times_;
+    std::vector<TrayRouteState> route_states_;
+    std::vector<uint32_t> route_targets_;
+};
+
+#endif //RECONFIGMANUS_TRAYSTATETABLE_H
@@ -0,0 +1,583 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GraphManager.h"
+#include "MESCore.h"
+#include "Metrics.h"
+#include "Tracer.h"
+#include "TCPClient.h"
+#include "mes_server_def.h"
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct ST_LoadGenOptions
+{
+    std::string graph_file;
+    std::string capabilities_file;
+    std::string products_file;
+    std::string host = "127.0.0.1";
+    uint16_t port = 0;              // 0 drives an in-process MESCore instead of a server
+    uint32_t trays = 20;
+    uint32_t first_tray_id = 1;
+    uint32_t orders = 1000;         // in-process only, a server creates its orders from its own config
+    uint8_t product_type = 0;
+    double duration_s = 10.0;
+    uint64_t max_decisions = 0;     // 0 for no limit
+    double speedup = 0.0;           // graph time units per wall second, 0 for no waiting at all
+    uint64_t seed = 1;
+    bool route_push = false;        // in-process only, a server takes it from its own config
+    bool print_stats = false;
+    std::string trace_file;         // in-process only, empty for no trace
+};
+
+// A decision reply, or a route push following one
+struct ST_LoadGenReply
+{
+    bool is_push = false;
+    ST_StationActionRsp rsp{};
+    ST_StationRoutePush push{};
+};
+
+class LoadGenTransport
+{
+public:
+    virtual ~LoadGenTransport() = default;
+    virtual void SendQuery(uint32_t msg_type, const ST_StationActionQuery & qry) = 0;
+    virtual bool PollReply(ST_LoadGenReply & out) = 0;
+    // MES metrics in the Prometheus text format
+    virtual bool FetchStats(std::string & out) = 0;
+    // Event trace as Chrome trace JSON, written by the in-process core or by the server to its trace_file
+    virtual bool DumpTrace(const std::string & file, uint32_t & out_events) = 0;
+};
+
+// Answers on the calling thread, the measured latency is the bare decision time
+class InProcessTransport final : public LoadGenTransport
+{
+public:
+    InProcessTransport(const json & j_graph, const json & j_capabilities, const json & j_products,
+        const ST_LoadGenOptions & options)
+    {
+        ST_MESCoreOptions core_options;
+        core_options.max_trays = std::max<uint32_t>(1024, options.trays);
+        core_options.route_push = options.route_push;
+        core_options.trace_events = options.trace_file.empty() ? 0 : 1u << 20;
+        core_options.order_seed = options.seed;
+        core_ = std::make_unique<MESCore>(j_graph, j_capabilities, j_products, core_options);
+        core_->CreateOrderBatch(options.orders, options.product_type);
+    }
+
+    [[nodiscard]] uint64_t GetOrderSeed() const { return core_->GetOrderSeed(); }
+
+    void SendQuery(const uint32_t msg_type, const ST_StationActionQuery & qry) override
+    {
+        ST_LoadGenReply reply;
+        reply.rsp = core_->AnswerStationQuery(msg_type, qry, &reply.push);
+        replies_.push_back(reply);
+        if (reply.push.route_length > 0)
+        {
+            reply.is_push = true;
+            replies_.push_back(reply);
+        }
+    }
+
+    bool PollReply(ST_LoadGenReply & out) override
+    {
+        if (replies_.empty())
+            return false;
+        out = replies_.front();
+        replies_.pop_front();
+        return true;
+    }
+
+    bool FetchStats(std::string & out) override
+    {
+        out = MESMetrics::Registry::Instance().RenderPrometheus();
+        return true;
+    }
+
+    bool DumpTrace(const std::string & file, uint32_t & out_events) override
+    {
+        std::ofstream f(file);
+        if (!f.is_open())
+            return false;
+        out_events = static_cast<uint32_t>(MESTrace::Tracer::Instance().DumpChromeTrace(f));
+        return f.good();
+    }
+
+private:
+    std::unique_ptr<MESCore> core_;
+    std::deque<ST_LoadGenReply> replies_;
+};
+
+// Talks to a running MESServer, the measured latency includes the loopback round trip
+class TCPTransport final : public LoadGenTransport, public TCPConn::ITCPClient<TCPConn::TCPMsg>
+{
+public:
+    bool Open(const std::string & host, const uint16_t port)
+    {
+        return Connect(host, port);
+    }
+
+    void SendQuery(const uint32_t msg_type, const ST_StationActionQuery & qry) override
+    {
+        TCPConn::TCPMsg msg;
+        msg.header.type = msg_type;
+        msg << qry;
+        Send(msg);
+    }
+
+    bool PollReply(ST_LoadGenReply & out) override
+    {
+        while (!Incoming().empty())
+        {
+            auto msg = Incoming().pop_front().msg;
+            if (msg.header.type == MSG_STATION_ACTION_RSP)
+            {
+                out.is_push = false;
+                msg >> out.rsp;
+                return true;
+            }
+            if (msg.header.type == MSG_STATION_ROUTE_PUSH)
+            {
+                out.is_push = true;
+                msg >> out.push;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool FetchStats(std::string & out) override
+    {
+        TCPConn::TCPMsg msg;
+        msg.header.type = MSG_MES_STATS_QUERY;
+        Send(msg);
+        // Replies still in flight from the run are dropped
+        const auto deadline = Clock::now() + std::chrono::seconds(2);
+        while (Clock::now() < deadline)
+        {
+            if (Incoming().empty())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            auto rsp = Incoming().pop_front().msg;
+            if (rsp.header.type != MSG_MES_STATS_RSP)
+                continue;
+            uint32_t length = 0;
+            rsp >> length;
+            out.resize(length);
+            for (auto it = out.rbegin(); it != out.rend(); ++it)
+                rsp >> *it;
+            return true;
+        }
+        return false;
+    }
+
+    bool DumpTrace(const std::string &, uint32_t & out_events) override
+    {
+        TCPConn::TCPMsg msg;
+        msg.header.type = MSG_MES_TRACE_DUMP_QUERY;
+        Send(msg);
+        const auto deadline = Clock::now() + std::chrono::seconds(10);
+        while (Clock::now() < deadline)
+        {
+            if (Incoming().empty())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            auto rsp_msg = Incoming().pop_front().msg;
+            if (rsp_msg.header.type != MSG_MES_TRACE_DUMP_RSP)
+                continue;
+            ST_TraceDumpRsp rsp;
+            rsp_msg >> rsp;
+            out_events = rsp.event_count;
+            return rsp.written != 0;
+        }
+        return false;
+    }
+};
+
+struct ST_TrayAgent
+{
+    uint32_t tray_id = 0;
+    uint32_t station = UINT32_MAX;      // station of the last query
+    uint64_t generation = 0;            // bumped to cancel the scheduled query
+    bool awaiting = false;              // a query is in flight
+    bool arrival_pending = false;       // released and not arrived yet, a route push may still redirect it
+    Clock::time_point sent_at{};
+};
+
+struct ST_LoadGenEvent
+{
+    Clock::time_point due;
+    uint32_t agent;
+    uint64_t generation;
+    uint32_t msg_type;
+    uint32_t station;
+
+    bool operator>(const ST_LoadGenEvent & other) const { return due > other.due; }
+};
+
+// Closed-loop tray simulation: each tray waits for its answer, spends the sampled service or transfer
+// time, then sends its next query.
+class LoadGenerator
+{
+public:
+    LoadGenerator(LoadGenTransport & transport, const GraphManager & plant, const uint32_t return_station,
+        const ST_LoadGenOptions & options)
+        : transport_(transport), plant_(plant), return_station_(return_station), options_(options)
+    {
+        agents_.resize(options.trays);
+        for (uint32_t i = 0; i < options.trays; ++i)
+            agents_[i].tray_id = options.first_tray_id + i;
+    }
+
+    void Run()
+    {
+        const auto start = Clock::now();
+        for (uint32_t i = 0; i < agents_.size(); ++i)
+            events_.push({start, i, 0, MSG_STATION_ACTION_QUERY, return_station_});
+
+        const auto stop_at = start + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options_.duration_s));
+        while (true)
+        {
+            auto now = Clock::now();
+            if (now >= stop_at || (options_.max_decisions > 0 && latencies_us_.size() >= options_.max_decisions))
+                break;
+
+            bool progressed = false;
+            while (!events_.empty() && events_.top().due <= now)
+            {
+                const auto event = events_.top();
+                events_.pop();
+                auto & agent = agents_[event.agent];
+                if (event.generation != agent.generation)
+                    continue;
+                agent.station = event.station;
+                agent.awaiting = true;
+                agent.arrival_pending = false;
+                agent.sent_at = Clock::now();
+                transport_.SendQuery(event.msg_type, ST_StationActionQuery{event.station, agent.tray_id});
+                progressed = true;
+            }
+
+            ST_LoadGenReply reply;
+            while (transport_.PollReply(reply))
+            {
+                if (reply.is_push)
+                    OnRoutePush(reply.push);
+                else
+                    OnResponse(reply.rsp);
+                progressed = true;
+            }
+
+            if (!progressed)
+                std::this_thread::yield();
+        }
+        elapsed_s_ = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void Report(std::ostream & os)
+    {
+        std::sort(latencies_us_.begin(), latencies_us_.end());
+        const auto percentile = [this](const double p) {
+            if (latencies_us_.empty())
+                return 0.0;
+            const auto rank = static_cast<size_t>(p * static_cast<double>(latencies_us_.size() - 1));
+            return latencies_us_[rank];
+        };
+        os << "seed:              " << options_.seed << "\n"
+           << "trays:             " << agents_.size() << "\n"
+           << "elapsed (s):       " << elapsed_s_ << "\n"
+           << "decisions:         " << latencies_us_.size() << "\n"
+           << "decisions/s:       " << static_cast<double>(latencies_us_.size()) / std::max(elapsed_s_, 1e-9) << "\n"
+           << "process starts:    " << executes_ << "\n"
+           << "route pushes:      " << pushes_ << "\n"
+           << "latency p50 (us):  " << percentile(0.50) << "\n"
+           << "latency p99 (us):  " << percentile(0.99) << "\n"
+           << "latency p999 (us): " << percentile(0.999) << "\n";
+    }
+
+private:
+    // Wall delay for a duration in graph time units
+    [[nodiscard]] Clock::duration Delay(const double graph_time) const
+    {
+        if (options_.speedup <= 0.0 || graph_time <= 0.0)
+            return Clock::duration::zero();
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(graph_time / options_.speedup));
+    }
+
+    [[nodiscard]] double SampleTransfer(const uint32_t tail, const uint32_t head) const
+    {
+        ST_TimeDist dist;
+        if (options_.speedup <= 0.0 || !plant_.GetArcTimeDist(tail, head, dist))
+            return 0.0;
+        return dist.generate_time();
+    }
+
+    [[nodiscard]] double SampleService(const uint32_t station) const
+    {
+        ST_TimeDist dist;
+        if (options_.speedup <= 0.0 || !plant_.GetVertexTimeDist(station, dist))
+            return 0.0;
+        return dist.generate_time();
+    }
+
+    ST_TrayAgent * FindAgent(const uint32_t tray_id)
+    {
+        const auto index = tray_id - options_.first_tray_id;
+        return index < agents_.size() ? &agents_[index] : nullptr;
+    }
+
+    void OnResponse(const ST_StationActionRsp & rsp)
+    {
+        auto * agent = FindAgent(rsp.qry.tray_id);
+        if (agent == nullptr || !agent->awaiting)
+            return;
+        const auto now = Clock::now();
+        latencies_us_.push_back(std::chrono::duration<double, std::micro>(now - agent->sent_at).count());
+        agent->awaiting = false;
+
+        const auto index = static_cast<uint32_t>(agent - agents_.data());
+        if (rsp.action_type == 1)
+        {
+            ++executes_;
+            events_.push({now + Delay(SampleService(agent->station)), index, agent->generation,
+                MSG_STATION_ACTION_DONE_QUERY, agent->station});
+            return;
+        }
+        // Released at a sink: the tray goes back to the order assigning station
+        const auto next = rsp.next_station_id != UINT32_MAX ? rsp.next_station_id : return_station_;
+        agent->arrival_pending = true;
+        events_.push({now + Delay(SampleTransfer(agent->station, next)), index, agent->generation,
+            MSG_STATION_ACTION_QUERY, next});
+    }
+
+    void OnRoutePush(const ST_StationRoutePush & push)
+    {
+        auto * agent = FindAgent(push.tray_id);
+        if (agent == nullptr || !agent->arrival_pending || push.route_length == 0)
+            return;
+        ++pushes_;
+        // Follow the whole route and query only at its end
+        double transfer = 0.0;
+        auto tail = agent->station;
+        for (uint32_t i = 0; i < push.route_length && i < MES_MAX_ROUTE_LENGTH; ++i)
+        {
+            transfer += SampleTransfer(tail, push.stations[i]);
+            tail = push.stations[i];
+        }
+        ++agent->generation;
+        events_.push({Clock::now() + Delay(transfer), static_cast<uint32_t>(agent - agents_.data()),
+            agent->generation, MSG_STATION_ACTION_QUERY, tail});
+    }
+
+    LoadGenTransport & transport_;
+    const GraphManager & plant_;
+    uint32_t return_station_;
+    ST_LoadGenOptions options_;
+
+    std::vector<ST_TrayAgent> agents_;
+    std::priority_queue<ST_LoadGenEvent, std::vector<ST_LoadGenEvent>, std::greater<>> events_;
+    std::vector<double> latencies_us_;
+    uint64_t executes_ = 0;
+    uint64_t pushes_ = 0;
+    double elapsed_s_ = 0.0;
+};
+
+bool LoadJson(const std::string & file, json & out)
+{
+    try
+    {
+        std::ifstream f(file);
+        if (!f.is_open())
+        {
+            std::cerr << "Cannot open file: " << file << "\n";
+            return false;
+        }
+        out = json::parse(f);
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Parsing failed (" << file << "):\n" << e.what() << "\n";
+        return false;
+    }
+}
+
+void PrintUsage()
+{
+    std::cerr << "Usage: MESLoadGen <graph_json> <capabilities_json> <products_json> [options]\n"
+              << "  --port P          drive the MESServer at host:P, otherwise an in-process MES core\n"
+              << "  --host H          server host (default 127.0.0.1)\n"
+              << "  --trays N         simulated trays (default 20)\n"
+              << "  --first-tray ID   first tray ID (default 1)\n"
+              << "  --orders N        orders to create, in-process only (default 1000)\n"
+              << "  --product T       product type of the orders (default: first in products_json)\n"
+              << "  --duration S      run time in seconds (default 10)\n"
+              << "  --decisions N     stop after N decisions\n"
+              << "  --speedup X       graph time units per second for service and transfer times,\n"
+              << "                    0 answers back to back (default 0)\n"
+              << "  --seed S          sampling seed, and order seed of an in-process MES core (default 1)\n"
+              << "  --route-push      enable route push, in-process only\n"
+              << "  --stats           print the MES metrics after the run\n"
+              << "  --trace FILE      trace tray events into FILE (in-process), or have the server write its\n"
+              << "                    trace_file after the run (enable trace_events in its config)\n";
+}
+
+bool ParseArgs(const int argc, char* argv[], ST_LoadGenOptions & out)
+{
+    if (argc < 4)
+        return false;
+    out.graph_file = argv[1];
+    out.capabilities_file = argv[2];
+    out.products_file = argv[3];
+    bool product_given = false;
+    for (int i = 4; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const auto next = [&]() -> const char * { return i + 1 < argc ? argv[++i] : nullptr; };
+        if (arg == "--route-push")
+        {
+            out.route_push = true;
+            continue;
+        }
+        if (arg == "--stats")
+        {
+            out.print_stats = true;
+            continue;
+        }
+        const char * value = next();
+        if (value == nullptr)
+            return false;
+        if (arg == "--port") out.port = static_cast<uint16_t>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--host") out.host = value;
+        else if (arg == "--trays") out.trays = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--first-tray") out.first_tray_id = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--orders") out.orders = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--product")
+        {
+            out.product_type = static_cast<uint8_t>(std::strtoul(value, nullptr, 10));
+            product_given = true;
+        }
+        else if (arg == "--duration") out.duration_s = std::strtod(value, nullptr);
+        else if (arg == "--decisions") out.max_decisions = std::strtoull(value, nullptr, 10);
+        else if (arg == "--speedup") out.speedup = std::strtod(value, nullptr);
+        else if (arg == "--seed") out.seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--trace") out.trace_file = value;
+        else
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    if (!product_given)
+        out.product_type = 0xFF;    // resolved from the products file
+    return out.trays > 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    ST_LoadGenOptions options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    json j_graph, j_capabilities, j_products;
+    if (!LoadJson(options.graph_file, j_graph) || !LoadJson(options.capabilities_file, j_capabilities) ||
+        !LoadJson(options.products_file, j_products))
+        return 1;
+
+    if (options.product_type == 0xFF)
+    {
+        if (j_products["products"].empty())
+        {
+            std::cerr << "No product defined in " << options.products_file << "\n";
+            return 1;
+        }
+        options.product_type = j_products["products"][0]["product_type"].get<uint8_t>();
+    }
+
+    // Trays start at, and return to, the order assigning station
+    uint32_t return_station = UINT32_MAX;
+    for (const auto & s : j_capabilities["stations"])
+    {
+        if (s.value("is_order_assigning_station", false))
+        {
+            return_station = s["id"].get<uint32_t>();
+            break;
+        }
+    }
+    if (return_station == UINT32_MAX)
+    {
+        std::cerr << "No order assigning station in " << options.capabilities_file << "\n";
+        return 1;
+    }
+
+    // Separate plant model for the timings, the MES adjusts the weights of its own graph
+    SetSamplingSeed(options.seed);
+    const GraphManager plant(j_graph);
+
+    std::unique_ptr<LoadGenTransport> transport;
+    if (options.port == 0)
+    {
+        auto in_process = std::make_unique<InProcessTransport>(j_graph, j_capabilities, j_products, options);
+        std::cout << "Driving an in-process MES core, order seed " << in_process->GetOrderSeed() << "\n";
+        transport = std::move(in_process);
+    }
+    else
+    {
+        auto tcp = std::make_unique<TCPTransport>();
+        if (!tcp->Open(options.host, options.port))
+        {
+            std::cerr << "Cannot connect to " << options.host << ":" << options.port << "\n";
+            return 1;
+        }
+        std::cout << "Driving MESServer at " << options.host << ":" << options.port << "\n";
+        transport = std::move(tcp);
+    }
+
+    LoadGenerator generator(*transport, plant, return_station, options);
+    generator.Run();
+    generator.Report(std::cout);
+    if (options.print_stats)
+    {
+        std::string stats;
+        if (transport->FetchStats(stats))
+            std::cout << "\n" << stats;
+        else
+            std::cerr << "No stats response from the MES\n";
+    }
+    if (!options.trace_file.empty())
+    {
+        uint32_t events = 0;
+        if (transport->DumpTrace(options.trace_file, events))
+            std::cout << "Trace of " << events << " events written" << (options.port == 0 ? " to " + options.trace_file : " by the server") << "\n";
+        else
+            std::cerr << "Trace dump failed\n";
+    }
+    return 0;
+}
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <nlohmann/json.hpp>
 #include "MESServer.h"
+#include "AsyncLogger.h"
 
 using json = nlohmann::json;
 #define DEFAULT_CONFIG_FILE "mes_server_cfg.json"
@@ -15,7 +16,8 @@ int main(int argc, char* argv[]) {
     std::string system_graph_file;
     std::string system_capabilities_file;
     std::string products_file;
-    json startup_order_batches = json::array();
+    json j_product_info;
+    ST_MESServerOptions options;
 
     // Load MES server config (bind port)
     json j_cfg;
@@ -26,7 +28,13 @@ int main(int argc, char* argv[]) {
         j_cfg["production_system"]["graph_file"].get_to(system_graph_file);
         j_cfg["production_system"]["capabilities_file"].get_to(system_capabilities_file);
         j_cfg["product_info"]["products_file"].get_to(products_file);
-        startup_order_batches = j_cfg["product_info"].value("startup_order_batches", json::array());
+        j_product_info = j_cfg["product_info"];
+        const auto & j_service = j_cfg["mes_service"];
+        ParseMESCoreOptions(j_service, options);
+        options.dispatch_threads = j_service.value("dispatch_threads", options.dispatch_threads);
+        options.trace_file = j_service.value("trace_file", options.trace_file);
+        options.journal_file = j_service.value("journal_file", options.journal_file);
+        MESLog::AsyncLogger::SetLevel(MESLog::LevelFromString(j_service.value("log_level", std::string("info"))));
     } catch (const std::exception& e) {
         std::cout << "Configuration file parsing failed (" << cfg_file << "):\n" << e.what();
         return 1;
@@ -62,13 +70,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    auto server = std::make_unique<MESServer>(bind_port, j_graph, j_capabilities, j_products);
-    for (const auto & batch_cfg : startup_order_batches)
-    {
-        const auto count = batch_cfg["count"].get<uint32_t>();
-        const auto product_type = batch_cfg["product_type"].get<uint8_t>();
-        server->CreateOrderBatch(count, product_type);
-    }
+    auto server = std::make_unique<MESServer>(bind_port, j_graph, j_capabilities, j_products, options);
+    server->GetCore().CreateStartupOrders(j_product_info);
 
     std::cout << "MES Server started at port: " << bind_port << "\n";
     server->Start();
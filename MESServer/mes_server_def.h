@@ -16,13 +16,6 @@ enum ORDER_RUN_STATUS
 	ORDER_DELETE
 };
 
-typedef struct
-{
-	uint32_t	tray_id;
-	bool		executing_order;
-	uint32_t	current_order_id;
-} ST_TrayInfo;
-
 // TODO simplest number to represent process for now
 typedef uint8_t ST_ProcessInfo;
 
@@ -46,5 +39,127 @@ typedef struct
 	uint32_t    next_station_id;
 } ST_StationActionRsp;
 
+// Completion time quote for the remaining processes of an order, in the graph time unit
+#define MSG_ORDER_ETA_QUERY						0x1049
+
+typedef struct
+{
+	uint32_t    order_id;
+} ST_OrderEtaQuery;
+
+#define MSG_ORDER_ETA_RSP						0x104A
+
+typedef struct
+{
+	uint32_t    order_id;
+	uint32_t    valid;      // 0 if the order is unknown, finished or cannot be routed
+	float       mean;
+	float       p50;
+	float       p95;
+	float       p99;
+} ST_OrderEtaRsp;
+
+
+// Batched station action queries, answered with one batch response frame.
+// Body layout: the items in order followed by a uint32_t item count (the count is the last field
+// written and the first one read). The response carries one ST_StationActionRsp per item, same order.
+#define MSG_STATION_ACTION_BATCH_QUERY			0x104B
+
+typedef struct
+{
+	uint32_t              query_type;   // MSG_STATION_ACTION_QUERY or MSG_STATION_ACTION_DONE_QUERY
+	ST_StationActionQuery qry;
+} ST_StationActionBatchItem;
+
+#define MSG_STATION_ACTION_BATCH_RSP			0x104C
+
+#define MES_MAX_BATCH_ITEMS						4096
+
+
+// Full route pushed after a station action response when route push is enabled. The tray follows
+// the stations without querying on the way and queries again at the last one, its process station.
+// A later push for the same tray replaces the route.
+#define MSG_STATION_ROUTE_PUSH					0x104D
+
+#define MES_MAX_ROUTE_LENGTH					32
+
+typedef struct
+{
+	uint32_t    tray_id;
+	uint32_t    order_id;
+	uint32_t    route_length;                       // valid entries in stations, 0 for no route
+	uint32_t    stations[MES_MAX_ROUTE_LENGTH];     // next station first, process station last
+} ST_StationRoutePush;
+
+
+// Runtime metrics in the Prometheus text format. The query has an empty body. The response body is the
+// text bytes followed by a uint32_t byte count (the count is the first field read).
+#define MSG_MES_STATS_QUERY						0x104E
+#define MSG_MES_STATS_RSP						0x104F
+
+
+// Writes the event trace ring to the server's trace_file as Chrome/Perfetto trace JSON. Empty query body.
+#define MSG_MES_TRACE_DUMP_QUERY				0x1050
+#define MSG_MES_TRACE_DUMP_RSP					0x1051
+
+typedef struct
+{
+	uint32_t    written;        // 0 if the file could not be written
+	uint32_t    event_count;    // events in the dump, 0 when tracing is disabled
+} ST_TraceDumpRsp;
+
+
+// Customer order with a priority (higher first) and a due time, released to trays before the production
+// targets in the order of the dispatch rule. due_in is in graph time units from the arrival of the message.
+#define MSG_CUSTOMER_ORDER_SUBMIT				0x1052
+
+typedef struct
+{
+	uint32_t    product_type;
+	uint32_t    priority;
+	float       due_in;
+} ST_CustomerOrderSubmit;
+
+#define MSG_CUSTOMER_ORDER_SUBMIT_RSP			0x1053
+
+typedef struct
+{
+	uint32_t    order_id;       // UINT32_MAX if the product type is not configured or due_in is not finite
+} ST_CustomerOrderSubmitRsp;
+
+// New priority and due time of a customer order not released yet, due_in from the arrival of the message
+#define MSG_CUSTOMER_ORDER_UPDATE				0x1054
+
+typedef struct
+{
+	uint32_t    order_id;
+	uint32_t    priority;
+	float       due_in;
+} ST_CustomerOrderUpdate;
+
+#define MSG_CUSTOMER_ORDER_UPDATE_RSP			0x1055
+
+typedef struct
+{
+	uint32_t    order_id;
+	uint32_t    updated;        // 0 if the order is not pending or due_in is not finite
+} ST_CustomerOrderUpdateRsp;
+
+// Withdraws a customer order not released yet
+#define MSG_CUSTOMER_ORDER_CANCEL				0x1056
+
+typedef struct
+{
+	uint32_t    order_id;
+} ST_CustomerOrderCancel;
+
+#define MSG_CUSTOMER_ORDER_CANCEL_RSP			0x1057
+
+typedef struct
+{
+	uint32_t    order_id;
+	uint32_t    cancelled;      // 0 if the order is not pending
+} ST_CustomerOrderCancelRsp;
+
 
 #endif
@@ -0,0 +1,413 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <vector>
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "AsyncLogger.h"
+#include "MESCore.h"
+#include "PlantGenerator.h"
+
+using json = nlohmann::json;
+
+// Heap allocation counters, every allocation of the process goes through the replaced operators below
+namespace {
+std::atomic<uint64_t> g_alloc_count{0};
+std::atomic<uint64_t> g_alloc_bytes{0};
+
+void * CountedAlloc(const std::size_t size, const std::size_t alignment = 0)
+{
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    void * p;
+    // The aligned operators always pass an alignment, so their deletes know which free to call
+    if (alignment != 0)
+#if defined(_WIN32)
+        p = _aligned_malloc(size == 0 ? 1 : size, alignment);   // no std::aligned_alloc in the MSVC and MinGW runtimes
+#else
+        p = std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment);
+#endif
+    else
+        p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+
+// Pairs with CountedAlloc, alignment must be the one the memory was allocated with
+void CountedFree(void * p, const std::size_t alignment = 0) noexcept
+{
+#if defined(_WIN32)
+    if (alignment != 0)
+    {
+        _aligned_free(p);
+        return;
+    }
+#else
+    (void)alignment;
+#endif
+    std::free(p);
+}
+}
+
+void * operator new(const std::size_t size) { return CountedAlloc(size); }
+void * operator new[](const std::size_t size) { return CountedAlloc(size); }
+void * operator new(const std::size_t size, const std::align_val_t al) { return CountedAlloc(size, static_cast<std::size_t>(al)); }
+void * operator new[](const std::size_t size, const std::align_val_t al) { return CountedAlloc(size, static_cast<std::size_t>(al)); }
+void operator delete(void * p) noexcept { CountedFree(p); }
+void operator delete[](void * p) noexcept { CountedFree(p); }
+void operator delete(void * p, std::size_t) noexcept { CountedFree(p); }
+void operator delete[](void * p, std::size_t) noexcept { CountedFree(p); }
+void operator delete(void * p, std::align_val_t al) noexcept { CountedFree(p, static_cast<std::size_t>(al)); }
+void operator delete[](void * p, std::align_val_t al) noexcept { CountedFree(p, static_cast<std::size_t>(al)); }
+void operator delete(void * p, std::size_t, std::align_val_t al) noexcept { CountedFree(p, static_cast<std::size_t>(al)); }
+void operator delete[](void * p, std::size_t, std::align_val_t al) noexcept { CountedFree(p, static_cast<std::size_t>(al)); }
+
+namespace {
+
+template <typename T>
+inline void DoNotOptimize(T const & value)
+{
+#if defined(_MSC_VER)
+    // No inline asm on MSVC: read the value through a volatile pointer and fence the compiler
+    static const void * volatile sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+// Minimal google-benchmark style state: `for (auto _ : state)` runs the timed iterations
+class BenchState
+{
+public:
+    explicit BenchState(const uint64_t iterations) : iterations_(iterations) {}
+
+    struct Iterator
+    {
+        BenchState * state;
+        uint64_t remaining;
+
+        bool operator!=(const Iterator &)
+        {
+            if (remaining != 0)
+                return true;
+            state->Finish();
+            return false;
+        }
+        void operator++() { --remaining; }
+        int operator*() const { return 0; }
+    };
+
+    Iterator begin()
+    {
+        allocs_ = g_alloc_count.load(std::memory_order_relaxed);
+        bytes_ = g_alloc_bytes.load(std::memory_order_relaxed);
+        start_ = std::chrono::steady_clock::now();
+        return {this, iterations_};
+    }
+    Iterator end() { return {this, 0}; }
+
+    [[nodiscard]] uint64_t Iterations() const { return iterations_; }
+    [[nodiscard]] double ElapsedSeconds() const { return elapsed_s_; }
+    [[nodiscard]] uint64_t Allocs() const { return allocs_; }
+    [[nodiscard]] uint64_t AllocBytes() const { return bytes_; }
+
+private:
+    void Finish()
+    {
+        const auto stop = std::chrono::steady_clock::now();
+        elapsed_s_ = std::chrono::duration<double>(stop - start_).count();
+        allocs_ = g_alloc_count.load(std::memory_order_relaxed) - allocs_;
+        bytes_ = g_alloc_bytes.load(std::memory_order_relaxed) - bytes_;
+    }
+
+    uint64_t iterations_;
+    std::chrono::steady_clock::time_point start_{};
+    double elapsed_s_ = 0.0;
+    uint64_t allocs_ = 0;
+    uint64_t bytes_ = 0;
+};
+
+struct ST_MicroBenchmark
+{
+    std::string name;
+    std::function<void(BenchState &)> fn;
+};
+
+// Grow the iteration count until one run takes at least min_time_s, then report that run
+void RunBenchmark(const ST_MicroBenchmark & bench, const double min_time_s)
+{
+    uint64_t iterations = 1;
+    while (true)
+    {
+        BenchState state(iterations);
+        bench.fn(state);
+        const double elapsed = state.ElapsedSeconds();
+        if (elapsed >= min_time_s || iterations >= 1000000000ull)
+        {
+            const auto n = static_cast<double>(state.Iterations());
+            std::printf("%-64s %12llu %12.1f %10.2f %12.1f\n", bench.name.c_str(),
+                static_cast<unsigned long long>(state.Iterations()), elapsed * 1e9 / n,
+                static_cast<double>(state.Allocs()) / n, static_cast<double>(state.AllocBytes()) / n);
+            return;
+        }
+        // Aim slightly past the target, at most 10x per step
+        const double scale = elapsed > 0.0 ? std::min(10.0, 1.4 * min_time_s / elapsed) : 10.0;
+        iterations = std::max(iterations + 1, static_cast<uint64_t>(static_cast<double>(iterations) * scale));
+    }
+}
+
+// One plant configuration with a loaded MES core and query inputs
+struct ST_BenchFixture
+{
+    std::string name;
+    std::unique_ptr<MESCore> core;
+    std::vector<uint32_t> stations;
+    std::vector<ST_ProcessInfo> processes;
+    uint8_t product_type = 0;
+};
+
+bool LoadJson(const std::filesystem::path & file, json & out)
+{
+    std::ifstream f(file);
+    if (!f.is_open())
+        return false;
+    out = json::parse(f, nullptr, false);
+    return !out.is_discarded();
+}
+
+bool MakeFixture(const std::string & name, const json & graph, const json & capabilities, const json & products,
+    ST_BenchFixture & out)
+{
+    out.name = name;
+    std::vector<ST_ProcessInfo> capable;
+    for (const auto & s : capabilities["stations"])
+    {
+        if (s.contains("process_capability"))
+            capable.push_back(static_cast<ST_ProcessInfo>(s["process_capability"].get<uint32_t>()));
+    }
+    // First product whose processes can all be executed in this plant
+    bool found = false;
+    for (const auto & p : products["products"])
+    {
+        const bool feasible = std::ranges::all_of(p["processes"], [&](const json & step) {
+            return std::ranges::find(capable, static_cast<ST_ProcessInfo>(step["process_id"].get<uint32_t>())) != capable.end();
+        });
+        if (feasible)
+        {
+            out.product_type = p["product_type"].get<uint8_t>();
+            found = true;
+            break;
+        }
+    }
+    if (!found)
+        return false;
+
+    for (const auto & v : graph["vertices"])
+        out.stations.push_back(v["id"].get<uint32_t>());
+    std::ranges::sort(capable);
+    capable.erase(std::unique(capable.begin(), capable.end()), capable.end());
+    out.processes = capable;
+    out.core = std::make_unique<MESCore>(graph, capabilities, products);
+    return true;
+}
+
+void AddBenchmarks(ST_BenchFixture & fx, std::vector<ST_MicroBenchmark> & out)
+{
+    auto * core = fx.core.get();
+    const auto & stations = fx.stations;
+    const auto & processes = fx.processes;
+    const auto prefix = fx.name + "/";
+
+    out.push_back({prefix + "GraphManager::FindShortestPath", [core, &stations](BenchState & state) {
+        std::mt19937 rng(1);
+        std::vector<uint32_t> path;
+        float length;
+        for ([[maybe_unused]] auto _ : state)
+        {
+            const auto tail = stations[rng() % stations.size()];
+            const auto head = stations[rng() % stations.size()];
+            DoNotOptimize(core->GetGraphManager().FindShortestPath(tail, head, path, length));
+        }
+    }});
+    out.push_back({prefix + "GraphManager::FindNextHop", [core, &stations](BenchState & state) {
+        std::mt19937 rng(1);
+        uint32_t next;
+        float length;
+        for ([[maybe_unused]] auto _ : state)
+        {
+            const auto tail = stations[rng() % stations.size()];
+            const auto head = stations[rng() % stations.size()];
+            DoNotOptimize(core->GetGraphManager().FindNextHop(tail, head, next, length));
+        }
+    }});
+    out.push_back({prefix + "MESCore::PlanRouteToProcessStation", [core, &stations, &processes](BenchState & state) {
+        std::mt19937 rng(1);
+        uint32_t next, target;
+        for ([[maybe_unused]] auto _ : state)
+        {
+            const auto station = stations[rng() % stations.size()];
+            const auto process = processes[rng() % processes.size()];
+            DoNotOptimize(core->PlanRouteToProcessStation(station, process, next, target));
+        }
+    }});
+    out.push_back({prefix + "ProcessManager::FindStationsForProcess", [core, &processes](BenchState & state) {
+        std::mt19937 rng(1);
+        std::list<uint32_t> found;
+        for ([[maybe_unused]] auto _ : state)
+            DoNotOptimize(core->GetProcessManager().FindStationsForProcess(processes[rng() % processes.size()], found));
+    }});
+    out.push_back({prefix + "ProcessManager::GetStationsForProcess", [core, &processes](BenchState & state) {
+        std::mt19937 rng(1);
+        for ([[maybe_unused]] auto _ : state)
+            DoNotOptimize(core->GetProcessManager().GetStationsForProcess(processes[rng() % processes.size()]));
+    }});
+    out.push_back({prefix + "ProcessManager::GetNextProcessToExecute", [core, &fx](BenchState & state) {
+        // A pool of assigned orders, some with executed processes
+        std::vector<uint32_t> order_ids;
+        auto & orders = core->GetOrderManager();
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+            const auto id = orders.CreateNewOrder(fx.product_type);
+            ST_ProcessInfo process;
+            for (uint32_t k = 0; k < i % 3 && core->GetProcessManager().GetNextProcessToExecute(id, process); ++k)
+                orders.OnOrderProcessSuccess(id, process, true);
+            order_ids.push_back(id);
+        }
+        size_t i = 0;
+        ST_ProcessInfo process;
+        for ([[maybe_unused]] auto _ : state)
+            DoNotOptimize(core->GetProcessManager().GetNextProcessToExecute(order_ids[i++ % order_ids.size()], process));
+    }});
+    out.push_back({prefix + "OrderManager::TryAssignNewOrderToTray", [&fx](BenchState & state) {
+        // Fresh manager per run, with one production target per iteration
+        OrderManager orders;
+        orders.AddProductionTarget(fx.product_type, static_cast<uint32_t>(std::min<uint64_t>(state.Iterations(), UINT32_MAX)));
+        uint32_t tray = 0;
+        uint32_t order_id;
+        for ([[maybe_unused]] auto _ : state)
+            DoNotOptimize(orders.TryAssignNewOrderToTray(tray++, order_id));
+    }});
+}
+
+// Product type selection on its own, independent of the plant
+void AddOrderReleaseBenchmarks(std::vector<ST_MicroBenchmark> & out)
+{
+    for (const auto policy : {OrderReleasePolicy::weighted_random, OrderReleasePolicy::round_robin, OrderReleasePolicy::heijunka})
+    {
+        for (const uint32_t num_types : {4u, 64u, 256u})
+        {
+            out.push_back({std::string("order_release/") + OrderReleasePolicyToString(policy) + "/" +
+                std::to_string(num_types) + "_types/ProductMix::Take", [policy, num_types](BenchState & state) {
+                ProductMix mix(policy);
+                const auto per_type = static_cast<uint32_t>(std::min<uint64_t>(state.Iterations() / num_types + 1, UINT32_MAX / num_types));
+                for (uint32_t type = 0; type < num_types; ++type)
+                    mix.Add(static_cast<uint8_t>(type), per_type + type);
+                std::mt19937 rng(1);
+                uint8_t product_type;
+                for ([[maybe_unused]] auto _ : state)
+                    DoNotOptimize(mix.Take(rng, product_type));
+            }});
+        }
+    }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filter;
+    double min_time_s = 0.2;
+    std::filesystem::path cfg_dir = "cfgs";
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc) min_time_s = std::strtod(argv[++i], nullptr);
+        else if (arg == "--cfg-dir" && i + 1 < argc) cfg_dir = argv[++i];
+        else
+        {
+            std::cerr << "Usage: MESMicroBench [--filter substring] [--min-time seconds] [--cfg-dir path]\n";
+            return 1;
+        }
+    }
+    MESLog::AsyncLogger::SetLevel(MESLog::Level::off);
+
+    json products;
+    if (!LoadJson(cfg_dir / "products.json", products))
+    {
+        std::cerr << "Cannot load " << (cfg_dir / "products.json") << ", set --cfg-dir\n";
+        return 1;
+    }
+
+    const std::pair<const char *, const char *> shipped[] = {
+        {"two_station_circular", "two_station_circular_system"},
+        {"twenty_station", "twenty_station_test_system"},
+        {"forty_station", "forty_station_test_system"},
+        {"modular", "modular_production_system"},
+    };
+    std::vector<ST_BenchFixture> fixtures;
+    for (const auto & [name, stem] : shipped)
+    {
+        json graph, capabilities;
+        ST_BenchFixture fx;
+        if (!LoadJson(cfg_dir / (std::string(stem) + "_graph.json"), graph) ||
+            !LoadJson(cfg_dir / (std::string(stem) + "_capabilities.json"), capabilities) ||
+            !MakeFixture(name, graph, capabilities, products, fx))
+        {
+            std::cerr << "Skipping " << name << ": config missing or no feasible product\n";
+            continue;
+        }
+        fixtures.push_back(std::move(fx));
+    }
+    const std::pair<PlantTopology, uint32_t> synthetic[] = {
+        {PlantTopology::ring, 100}, {PlantTopology::ring, 400}, {PlantTopology::ring, 1000},
+        {PlantTopology::grid, 400}, {PlantTopology::pools, 400},
+    };
+    for (const auto & [topology, n] : synthetic)
+    {
+        ST_PlantSpec spec;
+        spec.topology = topology;
+        spec.num_stations = n;
+        ST_PlantModel model;
+        ST_BenchFixture fx;
+        if (GeneratePlant(spec, model) && MakeFixture(std::string("synthetic_") + PlantTopologyToString(topology) + "_" +
+            std::to_string(n), model.graph, model.capabilities, model.products, fx))
+            fixtures.push_back(std::move(fx));
+    }
+
+    std::vector<ST_MicroBenchmark> benchmarks;
+    for (auto & fx : fixtures)
+        AddBenchmarks(fx, benchmarks);
+    AddOrderReleaseBenchmarks(benchmarks);
+
+    std::printf("%-64s %12s %12s %10s %12s\n", "Benchmark", "Iterations", "ns/op", "allocs/op", "bytes/op");
+    for (const auto & bench : benchmarks)
+    {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos)
+            continue;
+        RunBenchmark(bench, min_time_s);
+    }
+    return 0;
+}
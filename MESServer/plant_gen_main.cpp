@@ -0,0 +1,208 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "GraphManager.h"
+#include "PlantGenerator.h"
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+// Bytes currently allocated on the heap, 0 where the C library cannot tell
+size_t HeapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+void PrintUsage()
+{
+    std::cerr << "Usage:\n"
+              << "  MESPlantGen generate <out_prefix> [spec options]\n"
+              << "      writes <out_prefix>_graph.json, <out_prefix>_capabilities.json, <out_prefix>_products.json\n"
+              << "  MESPlantGen scale [spec options] [--sizes 50,100,...] [--queries N]\n"
+              << "      builds GraphManager for growing plants and reports build time, heap and routing latency\n"
+              << "Spec options:\n"
+              << "  --topology grid|ring|pools  (default ring)\n"
+              << "  --stations N                (default 100)\n"
+              << "  --processes N               (default 5)\n"
+              << "  --grid-width N              (grid, default square)\n"
+              << "  --chord-every N             (ring, default 8, 0 for none)\n"
+              << "  --buffer N                  (buffer capacity, default 3)\n"
+              << "  --jitter X                  (time scale jitter, default 0.2)\n"
+              << "  --seed S                    (default 1)\n";
+}
+
+bool ParseSpecOption(const std::string & arg, const char * value, ST_PlantSpec & spec)
+{
+    if (arg == "--topology") return PlantTopologyFromString(value, spec.topology);
+    else if (arg == "--stations") spec.num_stations = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    else if (arg == "--processes") spec.num_processes = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    else if (arg == "--grid-width") spec.grid_width = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    else if (arg == "--chord-every") spec.chord_every = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+    else if (arg == "--buffer") spec.buffer_capacity = static_cast<uint8_t>(std::strtoul(value, nullptr, 10));
+    else if (arg == "--jitter") spec.time_jitter = std::strtod(value, nullptr);
+    else if (arg == "--seed") spec.seed = std::strtoull(value, nullptr, 10);
+    else return false;
+    return true;
+}
+
+bool WriteJson(const std::string & file, const json & j)
+{
+    std::ofstream f(file);
+    if (!f.is_open())
+    {
+        std::cerr << "Cannot write " << file << "\n";
+        return false;
+    }
+    f << j.dump(2) << "\n";
+    return true;
+}
+
+int Generate(const std::string & prefix, const ST_PlantSpec & spec)
+{
+    ST_PlantModel model;
+    if (!GeneratePlant(spec, model))
+    {
+        std::cerr << "Invalid plant specification\n";
+        return 1;
+    }
+    if (!WriteJson(prefix + "_graph.json", model.graph) ||
+        !WriteJson(prefix + "_capabilities.json", model.capabilities) ||
+        !WriteJson(prefix + "_products.json", model.products))
+        return 1;
+    std::cout << "Generated " << PlantTopologyToString(spec.topology) << " plant with "
+              << model.graph["vertices"].size() << " stations and " << model.graph["arcs"].size() << " arcs\n";
+    return 0;
+}
+
+int Scale(ST_PlantSpec spec, const std::vector<uint32_t> & sizes, const uint32_t queries)
+{
+    std::printf("%-6s %9s %9s %12s %12s %14s %16s\n", "topo", "stations", "arcs", "build (ms)", "heap (MB)",
+        "next hop (ns)", "shortest (ns)");
+    for (const auto size : sizes)
+    {
+        spec.num_stations = size;
+        ST_PlantModel model;
+        if (!GeneratePlant(spec, model))
+            continue;
+
+        const auto heap_before = HeapInUse();
+        const auto build_start = std::chrono::steady_clock::now();
+        const GraphManager graph(model.graph);
+        const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+        const double heap_mb = static_cast<double>(HeapInUse() - heap_before) / (1024.0 * 1024.0);
+
+        std::vector<uint32_t> ids;
+        for (const auto & v : model.graph["vertices"])
+            ids.push_back(v["id"].get<uint32_t>());
+        std::vector<std::pair<uint32_t, uint32_t>> pairs(queries);
+        std::mt19937 rng(spec.seed);
+        for (auto & p : pairs)
+            p = {ids[rng() % ids.size()], ids[rng() % ids.size()]};
+
+        uint64_t checksum = 0;
+        uint32_t next;
+        float length;
+        auto start = std::chrono::steady_clock::now();
+        for (const auto & [tail, head] : pairs)
+            checksum += graph.FindNextHop(tail, head, next, length) ? next : 0;
+        const double next_hop_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / queries;
+
+        std::vector<uint32_t> path;
+        start = std::chrono::steady_clock::now();
+        for (const auto & [tail, head] : pairs)
+            checksum += graph.FindShortestPath(tail, head, path, length) ? path.size() : 0;
+        const double shortest_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / queries;
+
+        std::printf("%-6s %9zu %9zu %12.2f %12.2f %14.1f %16.1f\n", PlantTopologyToString(spec.topology),
+            model.graph["vertices"].size(), model.graph["arcs"].size(), build_ms, heap_mb, next_hop_ns, shortest_ns);
+        if (checksum == 0)
+            std::printf("  (no route found)\n");
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+    const std::string mode = argv[1];
+    int first_option = 2;
+    std::string prefix;
+    if (mode == "generate")
+    {
+        if (argc < 3)
+        {
+            PrintUsage();
+            return 1;
+        }
+        prefix = argv[2];
+        first_option = 3;
+    }
+    else if (mode != "scale")
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    ST_PlantSpec spec;
+    std::vector<uint32_t> sizes{50, 100, 200, 500, 1000, 2000};
+    uint32_t queries = 100000;
+    for (int i = first_option; i < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << "\n";
+            return 1;
+        }
+        const char * value = argv[i + 1];
+        if (ParseSpecOption(arg, value, spec))
+            continue;
+        if (arg == "--topology")
+        {
+            std::cerr << "Unknown topology: " << value << "\n";
+            PrintUsage();
+            return 1;
+        }
+        if (arg == "--sizes")
+        {
+            sizes.clear();
+            std::stringstream ss(value);
+            for (std::string item; std::getline(ss, item, ',');)
+                sizes.push_back(static_cast<uint32_t>(std::strtoul(item.c_str(), nullptr, 10)));
+        }
+        else if (arg == "--queries")
+            queries = std::max<uint32_t>(1, static_cast<uint32_t>(std::strtoul(value, nullptr, 10)));
+        else
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    return mode == "generate" ? Generate(prefix, spec) : Scale(spec, sizes, queries);
+}
@@ -0,0 +1,127 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include "MESCore.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <fstream>
+#include <stdexcept>
+
+namespace py = pybind11;
+
+namespace
+{
+    using U32Array = py::array_t<uint32_t, py::array::c_style | py::array::forcecast>;
+
+    json LoadJsonFile(const std::string & path)
+    {
+        std::ifstream f(path);
+        if (!f)
+            throw std::runtime_error("Cannot open " + path);
+        return json::parse(f);
+    }
+
+    py::tuple RspToTuple(const ST_StationActionRsp & rsp)
+    {
+        return py::make_tuple(rsp.action_type, rsp.next_station_id, rsp.order_id);
+    }
+
+    // Answer a batch of station queries in order. The input arrays are read in place when they are
+    // contiguous uint32, the responses are written straight into the returned arrays.
+    py::tuple AnswerStationQueries(MESCore & core, const U32Array & query_types,
+        const U32Array & workstation_ids, const U32Array & tray_ids)
+    {
+        const auto count = workstation_ids.size();
+        if (query_types.size() != count || tray_ids.size() != count)
+            throw std::invalid_argument("query_types, workstation_ids and tray_ids must have the same length");
+
+        U32Array action_types(count);
+        U32Array next_station_ids(count);
+        U32Array order_ids(count);
+        const auto * types = query_types.data();
+        const auto * stations = workstation_ids.data();
+        const auto * trays = tray_ids.data();
+        auto * actions = action_types.mutable_data();
+        auto * next_stations = next_station_ids.mutable_data();
+        auto * orders = order_ids.mutable_data();
+        {
+            py::gil_scoped_release release;
+            for (py::ssize_t i = 0; i < count; ++i)
+            {
+                const auto rsp = core.AnswerStationQuery(types[i], ST_StationActionQuery{stations[i], trays[i]});
+                actions[i] = rsp.action_type;
+                next_stations[i] = rsp.next_station_id;
+                orders[i] = rsp.order_id;
+            }
+        }
+        return py::make_tuple(action_types, next_station_ids, order_ids);
+    }
+}
+
+PYBIND11_MODULE(mes_core, m)
+{
+    m.doc() = "In-process MES decision core";
+    m.attr("MSG_STATION_ACTION_QUERY") = static_cast<uint32_t>(MSG_STATION_ACTION_QUERY);
+    m.attr("MSG_STATION_ACTION_DONE_QUERY") = static_cast<uint32_t>(MSG_STATION_ACTION_DONE_QUERY);
+
+    py::class_<MESCore>(m, "MESCore")
+        .def(py::init([](const std::string & graph_file, const std::string & capabilities_file,
+                const std::string & products_file, const uint32_t eta_threads, const uint32_t eta_samples,
+                const uint64_t eta_seed, const uint32_t max_trays, const std::string & dispatch_rule,
+                const double graph_time_per_second, const bool release_control, const bool release_adaptive) {
+                ST_MESCoreOptions options;
+                options.eta_threads = eta_threads;
+                options.eta_samples = eta_samples;
+                options.eta_seed = eta_seed;
+                options.max_trays = max_trays;
+                if (!DispatchRuleFromString(dispatch_rule, options.dispatch_rule))
+                    throw std::invalid_argument("unknown dispatch_rule \"" + dispatch_rule + "\"");
+                options.graph_time_per_second = graph_time_per_second;
+                options.release_control = release_control;
+                options.release_adaptive = release_adaptive;
+                return std::make_unique<MESCore>(LoadJsonFile(graph_file), LoadJsonFile(capabilities_file),
+                    LoadJsonFile(products_file), options);
+            }),
+            py::arg("graph_file"), py::arg("capabilities_file"), py::arg("products_file"),
+            py::arg("eta_threads") = 0u, py::arg("eta_samples") = 1000u, py::arg("eta_seed") = 1ull,
+            py::arg("max_trays") = 1024u, py::arg("dispatch_rule") = "edd", py::arg("graph_time_per_second") = 1.0,
+            py::arg("release_control") = false, py::arg("release_adaptive") = false)
+        .def("create_order_batch", &MESCore::CreateOrderBatch, py::arg("num"), py::arg("product_type"))
+        .def("submit_customer_order", &MESCore::SubmitCustomerOrder,
+            py::arg("product_type"), py::arg("priority"), py::arg("due_in"),
+            "Returns the order ID, or UINT32_MAX if the product type is not configured or due_in is not finite")
+        .def("update_customer_order", &MESCore::UpdateCustomerOrder,
+            py::arg("order_id"), py::arg("priority"), py::arg("due_in"),
+            "False if the order is not pending or due_in is not finite")
+        .def("cancel_customer_order", &MESCore::CancelCustomerOrder, py::arg("order_id"),
+            "False if the order is not pending")
+        .def("on_station_action_query",
+            [](MESCore & core, const uint32_t workstation_id, const uint32_t tray_id) {
+                return RspToTuple(core.OnStationActionQuery(ST_StationActionQuery{workstation_id, tray_id}));
+            },
+            py::arg("workstation_id"), py::arg("tray_id"),
+            "Returns (action_type, next_station_id, order_id)")
+        .def("on_station_action_done_query",
+            [](MESCore & core, const uint32_t workstation_id, const uint32_t tray_id) {
+                return RspToTuple(core.OnStationActionDoneQuery(ST_StationActionQuery{workstation_id, tray_id}));
+            },
+            py::arg("workstation_id"), py::arg("tray_id"),
+            "Returns (action_type, next_station_id, order_id)")
+        .def("answer_station_queries", &AnswerStationQueries,
+            py::arg("query_types"), py::arg("workstation_ids"), py::arg("tray_ids"),
+            "Answers the queries in order, returns uint32 arrays (action_types, next_station_ids, order_ids)")
+        .def("quote_order_completion",
+            [](MESCore & core, const uint32_t order_id) -> py::object {
+                ST_CompletionQuote quote;
+                bool valid;
+                {
+                    py::gil_scoped_release release;
+                    valid = core.QuoteOrderCompletion(order_id, quote);
+                }
+                if (!valid)
+                    return py::none();
+                return py::make_tuple(quote.mean, quote.p50, quote.p95, quote.p99);
+            },
+            py::arg("order_id"), "Returns (mean, p50, p95, p99), or None if the order cannot be quoted");
+}
@@ -0,0 +1,240 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+#include "AsyncLogger.h"
+#include "MESCore.h"
+#include "QueryJournal.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+struct ST_ReplayOptions
+{
+    std::string cfg_file;
+    std::string journal_file;
+    uint64_t order_seed = 0;        // 0 uses the seed recorded in the journal
+    uint32_t max_diffs = 10;        // diffs printed, all of them are counted
+    std::string log_level = "warn";
+};
+
+bool LoadJson(const std::string & file, json & out)
+{
+    try
+    {
+        std::ifstream f(file);
+        out = json::parse(f);
+        return true;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Parsing failed (" << file << "):\n" << e.what() << "\n";
+        return false;
+    }
+}
+
+void PrintUsage()
+{
+    std::cerr << "Usage: MESReplay <mes_server_cfg_json> <journal> [options]\n"
+              << "  Replays a journal written by MESServer (mes_service.journal_file) through a fresh MES core\n"
+              << "  built from the same server config, and compares each decision with the recorded one.\n"
+              << "  --order-seed S    override the order assignment seed recorded in the journal\n"
+              << "  --diffs N         decision diffs to print (default 10)\n"
+              << "  --log-level L     MES log level during the replay (default warn)\n";
+}
+
+bool ParseArgs(const int argc, char* argv[], ST_ReplayOptions & out)
+{
+    if (argc < 3)
+        return false;
+    out.cfg_file = argv[1];
+    out.journal_file = argv[2];
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        const std::string arg = argv[i];
+        const char * value = argv[i + 1];
+        if (arg == "--order-seed") out.order_seed = std::strtoull(value, nullptr, 10);
+        else if (arg == "--diffs") out.max_diffs = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+        else if (arg == "--log-level") out.log_level = value;
+        else
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return false;
+        }
+    }
+    return (argc - 3) % 2 == 0;
+}
+
+bool IsCustomerOrderRecord(const ST_JournalRecord & r)
+{
+    return r.msg_type == MSG_CUSTOMER_ORDER_SUBMIT || r.msg_type == MSG_CUSTOMER_ORDER_UPDATE ||
+        r.msg_type == MSG_CUSTOMER_ORDER_CANCEL;
+}
+
+bool SameDecision(const ST_JournalRecord & a, const ST_JournalRecord & b)
+{
+    if (IsCustomerOrderRecord(a))
+        return a.customer_order.order_id == b.customer_order.order_id && a.customer_order.applied == b.customer_order.applied;
+    // next_station_id is ignored by the cell when the action is execute
+    return a.rsp.order_id == b.rsp.order_id && a.rsp.action_type == b.rsp.action_type &&
+        (a.rsp.action_type == 1 || a.rsp.next_station_id == b.rsp.next_station_id);
+}
+
+void PrintDecision(std::ostream & os, const ST_JournalRecord & r)
+{
+    if (IsCustomerOrderRecord(r))
+    {
+        os << (r.customer_order.applied ? "applied" : "rejected") << " (order "
+           << static_cast<int64_t>(r.customer_order.order_id == UINT32_MAX ? -1 : r.customer_order.order_id) << ")";
+        return;
+    }
+    if (r.rsp.action_type == 1)
+        os << "execute";
+    else
+        os << "release to " << r.rsp.next_station_id;
+    os << " (order " << static_cast<int64_t>(r.rsp.order_id == UINT32_MAX ? -1 : r.rsp.order_id) << ")";
+}
+
+void PrintRecord(std::ostream & os, const ST_JournalRecord & r)
+{
+    os << "client " << r.client_id << " at " << r.now << ": ";
+    switch (r.msg_type)
+    {
+        case MSG_CUSTOMER_ORDER_SUBMIT:
+            os << "submit of product type " << r.customer_order.product_type;
+            break;
+        case MSG_CUSTOMER_ORDER_UPDATE:
+            os << "update of order " << r.customer_order.order_id;
+            break;
+        case MSG_CUSTOMER_ORDER_CANCEL:
+            os << "cancel of order " << r.customer_order.order_id;
+            break;
+        default:
+            os << "tray " << r.qry.tray_id << " at station " << r.qry.workstation_id
+               << (r.msg_type == MSG_STATION_ACTION_DONE_QUERY ? " (done)" : "");
+            break;
+    }
+}
+
+// Feeds one record to the core, out receives the outcome in the fields the record was journaled with
+void Replay(MESCore & core, const ST_JournalRecord & r, ST_StationRoutePush * push, ST_JournalRecord & out)
+{
+    out = r;
+    const auto & order = r.customer_order;
+    switch (r.msg_type)
+    {
+        case MSG_CUSTOMER_ORDER_SUBMIT:
+            out.customer_order.order_id = core.SubmitCustomerOrder(static_cast<uint8_t>(order.product_type),
+                static_cast<uint8_t>(order.priority), order.due_in);
+            out.customer_order.applied = out.customer_order.order_id != UINT32_MAX ? 1 : 0;
+            break;
+        case MSG_CUSTOMER_ORDER_UPDATE:
+            out.customer_order.applied = core.UpdateCustomerOrder(order.order_id, static_cast<uint8_t>(order.priority),
+                order.due_in) ? 1 : 0;
+            break;
+        case MSG_CUSTOMER_ORDER_CANCEL:
+            out.customer_order.applied = core.CancelCustomerOrder(order.order_id) ? 1 : 0;
+            break;
+        default:
+            out.rsp = core.AnswerStationQuery(r.msg_type, r.qry, push);
+            break;
+    }
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    ST_ReplayOptions options;
+    if (!ParseArgs(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+    MESLog::AsyncLogger::SetLevel(MESLog::LevelFromString(options.log_level));
+
+    QueryJournalReader reader;
+    if (!reader.Open(options.journal_file))
+    {
+        std::cerr << "Cannot read journal " << options.journal_file << " (missing, or written by another build)\n";
+        return 1;
+    }
+    std::vector<ST_JournalRecord> records;
+    for (ST_JournalRecord record; reader.Next(record);)
+        records.push_back(record);
+
+    // Same plant, orders and decision options as the recording server
+    json j_cfg, j_graph, j_capabilities, j_products;
+    if (!LoadJson(options.cfg_file, j_cfg))
+        return 1;
+    ST_MESCoreOptions core_options;
+    try
+    {
+        ParseMESCoreOptions(j_cfg["mes_service"], core_options);
+        if (!LoadJson(j_cfg["production_system"]["graph_file"].get<std::string>(), j_graph) ||
+            !LoadJson(j_cfg["production_system"]["capabilities_file"].get<std::string>(), j_capabilities) ||
+            !LoadJson(j_cfg["product_info"]["products_file"].get<std::string>(), j_products))
+            return 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Configuration file parsing failed (" << options.cfg_file << "):\n" << e.what() << "\n";
+        return 1;
+    }
+    core_options.order_seed = options.order_seed != 0 ? options.order_seed : reader.GetHeader().order_seed;
+    core_options.trace_events = 0;      // nothing dumps the trace of a replay
+
+    // The MES clock reads the recorded time of each message, startup orders were created at 0
+    MESCore core(j_graph, j_capabilities, j_products, core_options);
+    double replay_now = 0.0;
+    core.SetClock([&replay_now] { return replay_now; });
+    core.CreateStartupOrders(j_cfg["product_info"]);
+
+    // Messages are handled back to back, pushes are built as on the server so the tray states match
+    std::vector<ST_JournalRecord> replayed(records.size());
+    ST_StationRoutePush push;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        replay_now = records[i].now;
+        Replay(core, records[i], core_options.route_push ? &push : nullptr, replayed[i]);
+    }
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    MESLog::AsyncLogger::Instance().Flush();
+
+    size_t diffs = 0;
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        if (SameDecision(records[i], replayed[i]))
+            continue;
+        if (diffs++ < options.max_diffs)
+        {
+            std::cout << "#" << i << " ";
+            PrintRecord(std::cout, records[i]);
+            std::cout << ": recorded ";
+            PrintDecision(std::cout, records[i]);
+            std::cout << ", replayed ";
+            PrintDecision(std::cout, replayed[i]);
+            std::cout << "\n";
+        }
+    }
+
+    const double recorded_s = records.size() > 1
+        ? static_cast<double>(records.back().received_ns - records.front().received_ns) * 1e-9 : 0.0;
+    std::cout << "order seed:        " << core_options.order_seed << "\n"
+              << "decisions:         " << records.size() << "\n"
+              << "diffs:             " << diffs << "\n"
+              << "recorded span (s): " << recorded_s << "\n"
+              << "replay (s):        " << elapsed_s << "\n"
+              << "decisions/s:       " << (elapsed_s > 0 ? static_cast<double>(records.size()) / elapsed_s : 0.0) << "\n";
+    return diffs == 0 ? 0 : 2;
+}
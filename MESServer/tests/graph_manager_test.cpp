@@ -0,0 +1,84 @@
+//
+// Created by bohanleng on 16/10/2026.
+//
+
+#include <cstdlib>
+#include <iostream>
+#include "GraphManager.h"
+
+namespace {
+
+int failures = 0;
+
+void Check(const bool condition, const char * what)
+{
+    if (condition)
+        return;
+    std::cout << "FAILED: " << what << std::endl;
+    ++failures;
+}
+
+json Station(const uint32_t id)
+{
+    return {{"id", id}, {"name", "Station " + std::to_string(id)}, {"buffer_capacity", 5},
+        {"service_time_distribution", {{"type", "normal"}, {"parameters", {5.0, 0.5}}}}};
+}
+
+json Arc(const uint32_t tail, const uint32_t head)
+{
+    return {{"tail", tail}, {"head", head},
+        {"transfer_time_distribution", {{"type", "normal"}, {"parameters", {10.0, 1.0}}}}};
+}
+
+// Station 1 reaches the candidates 2 and 3 at the same distance
+json TwoCandidatePlant()
+{
+    return {{"vertices", {Station(1), Station(2), Station(3)}}, {"arcs", {Arc(1, 2), Arc(1, 3)}}};
+}
+
+void TestLessOccupiedCandidateWins()
+{
+    GraphManager graph(TwoCandidatePlant());
+    for (int i = 0; i < 3; ++i)
+        graph.OnTrayArrived(2);
+    graph.OnTrayArrived(3);
+
+    uint32_t target = 0, next = 0;
+    float cost = 0.0f;
+    Check(graph.FindLeastCongestedVertex(1, {2, 3}, target, next, cost), "candidate found");
+    Check(target == 3 && next == 3, "less occupied candidate chosen");
+    Check(cost == 15.0f, "one queued tray costs one service time");
+}
+
+void TestTrayInServiceCountedOnce()
+{
+    // Station 2: one tray in service, station 3: two trays queued
+    GraphManager graph(TwoCandidatePlant());
+    graph.OnTrayArrived(2);
+    graph.AddTimeDistToAllPathsToVertex(2);
+    graph.OnTrayArrived(3);
+    graph.OnTrayArrived(3);
+
+    uint32_t target = 0, next = 0;
+    float cost = 0.0f;
+    Check(graph.FindLeastCongestedVertex(1, {2, 3}, target, next, cost), "candidate found");
+    Check(target == 2, "candidate with fewer trays chosen");
+    Check(cost == 15.0f, "tray in service counted by the arc weight only");
+
+    graph.AddTimeDistToAllPathsToVertex(2, false);
+    graph.OnTrayDeparted(2);
+    Check(graph.FindLeastCongestedVertex(1, {2, 3}, target, next, cost) && target == 2 && cost == 10.0f,
+        "idle candidate after the service is done");
+}
+
+}
+
+int main()
+{
+    TestLessOccupiedCandidateWins();
+    TestTrayInServiceCountedOnce();
+    if (failures > 0)
+        return EXIT_FAILURE;
+    std::cout << "GraphManager tests passed" << std::endl;
+    return EXIT_SUCCESS;
+}